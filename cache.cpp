@@ -0,0 +1,182 @@
+//==============================================================================
+//  _____ __  __        __  ____   ____ ___  _  __   
+// | ____|  \/  |      / /_| ___| / ___( _ )/ |/ /_  
+// |  _| | |\/| |_____| '_ \___ \| |   / _ \| | '_ \ 
+// | |___| |  | |_____| (_) |__) | |__| (_) | | (_) |
+// |_____|_|__|_|___ __\___/____/ \____\___/|_|\___/ 
+// | ____/ ___||  _ \___ /___ \                      
+// |  _| \___ \| |_) ||_ \ __) |                     
+// | |___ ___) |  __/___) / __/                      
+// |_____|____/|_|  |____/_____|                     
+//
+//------------------------------------------------------------------------------                                                   
+// Copyright (C),2019 Andrew John Jacobs
+// All rights reserved.
+//
+// This work is made available under the terms of the Creative Commons
+// Attribution-NonCommercial-ShareAlike 4.0 International license. Open the
+// following URL to see the details.
+//
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//------------------------------------------------------------------------------
+// Notes:
+//
+//==============================================================================
+
+#include <Arduino.h>
+
+#pragma GCC optimize ("-O3")
+
+#include "Emulator.h"
+
+//==============================================================================
+
+// Determine if an opcode must be the last in a block because it transfers
+// control, changes the processor mode or may leave the program counter at
+// somewhere other than the following instruction.
+static bool isFinal(uint8_t opcode)
+{
+	switch (opcode) {
+	case 0x00:	case 0x02:	case 0x10:	case 0x20:	case 0x22:	case 0x28:
+	case 0x30:	case 0x40:	case 0x44:	case 0x4c:	case 0x50:	case 0x54:
+	case 0x5c:	case 0x60:	case 0x6b:	case 0x6c:	case 0x70:	case 0x7c:
+	case 0x80:	case 0x82:	case 0x90:	case 0xb0:	case 0xc2:	case 0xcb:
+	case 0xd0:	case 0xdb:	case 0xdc:	case 0xe2:	case 0xf0:	case 0xfb:
+	case 0xfc:
+		return (true);
+	}
+	return (false);
+}
+
+// Determine if an opcode can appear in an idle loop because it only reads
+// memory, sets registers and flags or branches.
+static bool isQuiet(uint8_t opcode)
+{
+	switch (opcode) {
+	case 0x01:	case 0x03:	case 0x05:	case 0x07:	case 0x09:	case 0x0d:
+	case 0x0f:	case 0x10:	case 0x11:	case 0x12:	case 0x13:	case 0x15:
+	case 0x17:	case 0x18:	case 0x19:	case 0x1d:	case 0x1f:	case 0x21:
+	case 0x23:	case 0x24:	case 0x25:	case 0x27:	case 0x29:	case 0x2c:
+	case 0x2d:	case 0x2f:	case 0x30:	case 0x31:	case 0x32:	case 0x33:
+	case 0x34:	case 0x35:	case 0x37:	case 0x38:	case 0x39:	case 0x3c:
+	case 0x3d:	case 0x3f:	case 0x41:	case 0x43:	case 0x45:	case 0x47:
+	case 0x49:	case 0x4c:	case 0x4d:	case 0x4f:	case 0x50:	case 0x51:
+	case 0x52:	case 0x53:	case 0x55:	case 0x57:	case 0x59:	case 0x5d:
+	case 0x5f:	case 0x70:	case 0x80:	case 0x89:	case 0x8a:	case 0x90:
+	case 0x98:	case 0x9b:	case 0xa0:	case 0xa1:	case 0xa2:	case 0xa3:
+	case 0xa4:	case 0xa5:	case 0xa6:	case 0xa7:	case 0xa8:	case 0xa9:
+	case 0xaa:	case 0xac:	case 0xad:	case 0xae:	case 0xaf:	case 0xb0:
+	case 0xb1:	case 0xb2:	case 0xb3:	case 0xb4:	case 0xb5:	case 0xb6:
+	case 0xb7:	case 0xb8:	case 0xb9:	case 0xbb:	case 0xbc:	case 0xbd:
+	case 0xbe:	case 0xbf:	case 0xc0:	case 0xc1:	case 0xc3:	case 0xc4:
+	case 0xc5:	case 0xc7:	case 0xc9:	case 0xcc:	case 0xcd:	case 0xcf:
+	case 0xd0:	case 0xd1:	case 0xd2:	case 0xd3:	case 0xd5:	case 0xd7:
+	case 0xd9:	case 0xdd:	case 0xdf:	case 0xe0:	case 0xe4:	case 0xea:
+	case 0xec:	case 0xf0:
+		return (true);
+	}
+	return (false);
+}
+
+// Discard all the decoded blocks and the links between them.
+void Cache::flush(void)
+{
+	for (register int index = 0; index < CACHE_BLOCKS; ++index) {
+		register Block &block = blocks[index];
+
+		block.pOpcodeSet = NULL;
+		block.slot = 0;
+		for (register int link = 0; link < CACHE_LINKS; ++link)
+			block.pLink[link] = NULL;
+	}
+	pLast = &blocks[0];
+}
+
+// Return the dispatch code for a fused pair of opcodes or zero if they
+// are not fused.
+static uint16_t fusionOf(uint8_t first, uint8_t second)
+{
+#define FUSE_CASE(A,B) \
+	case 0x##A##B:	return (FUSED_BASE + FUSE_##A##_##B);
+
+	switch ((first << 8) | second) {
+	ALL_FUSIONS(FUSE_CASE)
+	}
+	return (0);
+}
+
+// Decode a straight-line run of instructions into a cache block, copying
+// the instruction bytes and resolving the opcode handlers for the mode.
+// An instruction that forms a fused pair with the one after it is given
+// the pair's dispatch code. A final opcode only continues the block if it
+// begins a pair.
+//
+// A WDM always starts a new block so the cycles spent before it are known
+// when it raises an interrupt flag.
+//
+// A block of quiet opcodes that ends by branching or jumping back to its
+// own start is marked as a possible idle loop.
+void Cache::decode(Block &block, uint32_t address, const OpcodeSet *pOpcodeSet)
+{
+	register uint32_t	bank = address & 0xff0000;
+	register uint16_t	offset = address;
+	register uint8_t	count = 0;
+	register uint8_t	bytes = 0;
+	register bool		paired = false;
+	register bool		quiet = true;
+	register uint8_t	last = 0;
+
+	block.address = address;
+	block.pOpcodeSet = pOpcodeSet;
+	block.slot = 0;
+	for (register int link = 0; link < CACHE_LINKS; ++link)
+		block.pLink[link] = NULL;
+
+	do {
+		register uint8_t	opcode = Memory::getByte(bank | offset);
+		register uint8_t	length = pOpcodeSet->length[opcode];
+
+		if (bytes + length > CACHE_BYTES) break;
+		if (count && (opcode == 0x42)) break;
+
+		if (count && !paired) {
+			register uint16_t	code = fusionOf(block.code[count - 1], opcode);
+
+			if (code) {
+				block.code[count - 1] = code;
+				paired = true;
+			}
+		}
+		else
+			paired = false;
+
+		if (!isQuiet(last = opcode)) quiet = false;
+
+		block.code[count] = opcode;
+		block.pOpcode[count++] = pOpcodeSet->pOpcode[opcode];
+		while (length--)
+			block.bytes[bytes++] = Memory::getByte(bank | offset++);
+
+		if (isFinal(opcode)) {
+			if (paired || !fusionOf(opcode, Memory::getByte(bank | offset))) break;
+		}
+	} while (count < CACHE_INSNS);
+
+	block.idle = false;
+	if (quiet) {
+		switch (last) {
+		case 0x4c:
+			block.idle = (uint16_t)(block.bytes[bytes - 2] | (block.bytes[bytes - 1] << 8)) == (uint16_t) address;
+			break;
+		case 0x10:	case 0x30:	case 0x50:	case 0x70:
+		case 0x80:	case 0x90:	case 0xb0:	case 0xd0:	case 0xf0:
+			block.idle = (uint16_t)(offset + (int8_t) block.bytes[bytes - 1]) == (uint16_t) address;
+			break;
+		}
+	}
+
+	block.count = count;
+	block.last = bank | (uint16_t)(offset - 1);
+	block.version[0] = Memory::watch(block.address);
+	block.version[1] = Memory::watch(block.last);
+}
@@ -0,0 +1,54 @@
+#===============================================================================
+# ROM Image Packer
+#-------------------------------------------------------------------------------
+# Copyright (C),2019 Andrew John Jacobs
+# All rights reserved.
+#
+# This work is made available under the terms of the Creative Commons
+# Attribution-NonCommercial-ShareAlike 4.0 International license. Open the
+# following URL to see the details.
+#
+# http://creativecommons.org/licenses/by-nc-sa/4.0/
+#-------------------------------------------------------------------------------
+#
+# Notes:
+#
+# Converts a ROM image written by the linker as a list of C byte values into
+# a PackedRom that only holds the 4K blocks that are not all zeroes.
+#
+# Usage: python pack.py name input.h output.h
+#-------------------------------------------------------------------------------
+
+import re
+import sys
+
+BLOCK_SIZE = 4096
+
+def main(name, source, target):
+    with open(source) as file:
+        image = [int(value, 16) for value in re.findall(r'0x([0-9A-Fa-f]{2})', file.read())]
+
+    blocks = [image[start:start + BLOCK_SIZE] for start in range(0, len(image), BLOCK_SIZE)]
+    data = []
+    index = []
+    for block in blocks:
+        if any(block):
+            data.append(block)
+            index.append(len(data))
+        else:
+            index.append(0)
+
+    with open(target, 'w') as file:
+        file.write('// Packed from %s: %d of %d blocks stored\n\n' % (source, len(data), len(blocks)))
+        file.write('static const uint8_t %sData [] =\n{\n' % name)
+        for block in data:
+            for start in range(0, BLOCK_SIZE, 16):
+                file.write('\t' + ' '.join('0x%02X,' % value for value in block[start:start + 16]) + '\n')
+        file.write('};\n\n')
+        file.write('static const uint8_t %sIndex [] =\n{\n' % name)
+        file.write('\t' + ' '.join('%d,' % value for value in index) + '\n')
+        file.write('};\n\n')
+        file.write('const PackedRom %s = { %d, %sIndex, %sData };\n' % (name, len(blocks), name, name))
+
+if __name__ == '__main__':
+    main(*sys.argv[1:4])
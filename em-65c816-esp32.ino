@@ -32,6 +32,10 @@
 #include "memory.h"
 #include "emulator.h"
 #include "fifo.h"
+#include "scheduler.h"
+
+#include <esp_heap_caps.h>
+#include <SPIFFS.h>
 
 //==============================================================================
 
@@ -41,46 +45,269 @@ const uint8_t   boot [4 * 1024] =
 #include "boot.h"
 };
 
-// 256K OS/Application ROM images
-const uint8_t   code [256 * 1024] =
-{
+// 256K OS/Application ROM images, packed to leave out blocks of zeroes
 #include "rom0.h"
 #include "rom1.h"
 #include "rom2.h"
 #include "rom3.h"
-};
 
 //==============================================================================
 
+// The most emulated cycles to execute in one run
+#define RUN_CYCLES      4096
+
+// The initial emulated clock frequency used to pace the CPU and time
+// devices, and the cycles between timer interrupts, samples of the UART
+// FIFOs (one character time at 115200 baud) and pacing checks
+#define CPU_CLOCK       8000000
+
+// The highest clock rate in MHz that a WDM call can set, the most that
+// fits in the 32-bit cycle frequency
+#define MAX_CLOCK       (UINT32_MAX / 1000000)
+#define TIMER_CYCLES    (frequency / CLK_FREQ)
+#define UART_CYCLES     (frequency / 11520)
+#define PACE_CYCLES     (frequency / PACE_RATE)
+
+// The number of pacing checks per second and how far the emulation may fall
+// behind real time (in uSec) before it stops trying to catch up
+#define PACE_RATE       100
+#define PACE_LAG        100000
+
+// The expansion RAM pool paged through the window at $02:0000-$03:FFFF
+#define POOL_PAGES      512             // 2M in 4K pages
+#define WINDOW_BASE     0x020000
+#define WINDOW_BLOCKS   32
+
+// The SPIFFS file the machine is saved to when the processor asks and
+// resumed from at boot, and the save states returned by WDM $51
+#define STATE_FILE      "/state.bin"
+#define SAVE_DONE       0x0000
+#define SAVE_PENDING    0x0001
+#define SAVE_FAILED     0xffff
+
+// The number of runs between passes that age the RAM blocks and migrate
+// them between the fast and slow tiers
+#define AGE_RUNS        256
+
+// Run the processor alone on core 1 and all the devices on core 0. The two
+// only share the UART FIFOs, the interrupt flags, a pair of clock words and
+// a flag asking for the FIFOs to be sampled, all of which are lock free.
+#ifndef SPLIT_CORES
+#define SPLIT_CORES     1
+#endif
+
 VideoRAM        video;
+Emulator        emulator;
 
-TaskHandle_t    timerTask;
+TaskHandle_t    emulatorTask;
+#if SPLIT_CORES
+TaskHandle_t    devicesTask;
+#else
 TaskHandle_t    u1rxTask;
 TaskHandle_t    u1txTask;
+#endif
 
 uint32_t        cycles;
+uint32_t        instructions;
 uint32_t        start;
 uint32_t        delta;
+uint32_t        runs;
 
 Fifo<32> u1rx;
 Fifo<32> u1tx;
 
-// Signal timer interrupt at the configured rate
-void doTimerTask (void *pArg)
+// The contents of a FIFO read from a saved state. Only the task on the
+// device side of the FIFO may put them in place, while the processor's task
+// waits, so each end of the FIFO still has a single writer.
+struct Refill {
+    std::atomic<bool>   pending;
+    uint8_t             count;
+    uint8_t             data [32];
+};
+
+Refill          u1rxRefill;
+Refill          u1txRefill;
+
+Scheduler<8>    scheduler;
+
+std::atomic<uint32_t>   frequency (CPU_CLOCK);
+std::atomic<bool>       turbo (false);
+std::atomic<uint32_t>   speed (0);
+uint32_t        deadline;
+uint32_t        sampled;
+uint64_t        sampledCycle;
+
+// The cycles the processor has actually executed, leaving out those it
+// skipped while waiting or in an idle loop, and the count at the last
+// speed report
+std::atomic<uint32_t>   executed (0);
+uint32_t        sampledExecuted;
+
+#if SPLIT_CORES
+// The emulated cycle the processor may run up to, and the emulated cycle
+// and real time of the last pacing check that set it
+std::atomic<uint32_t>   horizon (0);
+uint32_t        pacedCycle;
+uint32_t        pacedAt;
+#endif
+
+uint8_t        *pool [POOL_PAGES];
+uint16_t        window [WINDOW_BLOCKS];
+
+uint16_t        saving = SAVE_DONE;
+
+// Keep the emulated clock in step with real time. Each check is due a fixed
+// time after the last so drift does not accumulate, and the task sleeps
+// while it is ahead (with split cores the devices hold back the horizon
+// instead). A turbo run never sleeps and reports its speed every second,
+// both as the rate cycles were executed and as the rate emulated time
+// passed, which is much higher while the processor idles.
+void onPace (uint64_t when)
 {
-    for (;;) {
-        delay (1000 / CLK_FREQ);
+    uint32_t now = micros ();
+
+    if (now - sampled >= 1000000) {
+        uint32_t done = executed.load (std::memory_order_relaxed);
+        uint32_t rate = (uint64_t)(done - sampledExecuted) * 1000 / (now - sampled);
+        uint32_t emulated = (when - sampledCycle) * 1000 / (now - sampled);
+
+        speed = rate;
+        if (turbo)
+            Serial.printf (">> %d.%03d MHz executed, %d.%03d MHz emulated\n",
+                rate / 1000, rate % 1000, emulated / 1000, emulated % 1000);
+        sampled = now;
+        sampledCycle = when;
+        sampledExecuted = done;
+    }
 
-        Emulator::ifr.tmr = 1;
+    deadline += 1000000 / PACE_RATE;
+    if (turbo)
+        deadline = now;
+    else {
+        int32_t ahead = deadline - now;
+
+        if (ahead < -PACE_LAG)
+            deadline = now;
+#if !SPLIT_CORES
+        else if (ahead >= 1000)
+            delay (ahead / 1000);
+#endif
     }
+#if SPLIT_CORES
+    pacedCycle = when;
+    pacedAt = deadline;
+#endif
+    scheduler.schedule (when + PACE_CYCLES, onPace);
+}
+
+// Signal timer interrupt at the configured rate of emulated time
+void onTimer (uint64_t when)
+{
+    emulator.raise (INT_TMR);
+    scheduler.schedule (when + TIMER_CYCLES, onTimer);
+}
+
+// Sample the UART FIFOs. The WDM functions that access the FIFOs update the
+// flags as they go.
+void sampleUart (void)
+{
+    emulator.signal (INT_U1RX, !u1rx.isEmpty ());
+    emulator.signal (INT_U1TX, !u1tx.isFull ());
+}
+
+#if SPLIT_CORES
+// Set by the UART event on the devices core for the processor's task to
+// sample the FIFOs before its next run. Only that task sets the UART flags,
+// so a late sample cannot undo a change made by a WDM call.
+std::atomic<bool>       uartDue (false);
+#endif
+
+void onUart (uint64_t when)
+{
+#if SPLIT_CORES
+    uartDue.store (true, std::memory_order_release);
+#else
+    sampleUart ();
+#endif
+    scheduler.schedule (when + UART_CYCLES, onUart);
+}
+
+// Replace the contents of a FIFO with saved values if a restore is waiting
+// for them and wake the processor's task. Called by the task on the device
+// side of the FIFO.
+void refill (Fifo<32> &fifo, Refill &refill)
+{
+    if (!refill.pending.load (std::memory_order_acquire)) return;
+
+    fifo.clear ();
+    for (uint8_t index = 0; (index < refill.count) && !fifo.isFull (); ++index)
+        fifo.enqueue (refill.data [index]);
+    refill.pending.store (false, std::memory_order_release);
+    xTaskNotifyGive (emulatorTask);
 }
 
+#if SPLIT_CORES
+// Transfer Serial data into the RX FIFO and out of the TX FIFO
+void pollUart (void)
+{
+    while (Serial.available () && !u1rx.isFull ())
+        u1rx.enqueue (Serial.read ());
+    while (Serial.availableForWrite () && !u1tx.isEmpty ())
+        Serial.write (u1tx.dequeue ());
+}
+
+// Run all the devices on their own core. Each pass catches the scheduler
+// up with the processor's clock, firing the events that have become due,
+// then lets the processor run up to the next event, at most one pacing
+// interval ahead, or less if that would put it ahead of real time.
+//
+// The processor notifies this task when it reaches the horizon. A horizon
+// held back by real time can only move after a delay, otherwise the task
+// sleeps until notified, or for a tick to poll the UART.
+void doDevicesTask (void *pArg)
+{
+    uint32_t seen = emulator.now ();
+
+    for (;;) {
+        uint32_t now = emulator.now ();
+
+        refill (u1rx, u1rxRefill);
+        refill (u1tx, u1txRefill);
+        pollUart ();
+        scheduler.advance (now - seen);
+        seen = now;
+
+        uint32_t limit = now + scheduler.until (PACE_CYCLES);
+        bool held = false;
+
+        if (!turbo) {
+            uint32_t paced = pacedCycle + (int64_t)(int32_t)(micros () - pacedAt) * frequency / 1000000;
+
+            if ((int32_t)(paced - limit) < 0) {
+                limit = paced;
+                held = true;
+            }
+        }
+        if (horizon.exchange (limit, std::memory_order_release) != limit)
+            xTaskNotifyGive (emulatorTask);
+
+        if (held)
+            delay (1);
+        else
+            ulTaskNotifyTake (pdTRUE, 1);
+    }
+}
+#else
 // Transfer Serial data into RX FIFO
 void doU1rxTask (void *pArg)
 {
     for (;;) {
-        while (Serial.available () && !u1rx.isFull ())
-            u1rx.enqueue (Serial.read ());
+        refill (u1rx, u1rxRefill);
+        if (Serial.available () && !u1rx.isFull ()) {
+            while (Serial.available () && !u1rx.isFull ())
+                u1rx.enqueue (Serial.read ());
+            xTaskNotifyGive (emulatorTask);
+        }
         delay (1);
     }
 }
@@ -89,11 +316,198 @@ void doU1rxTask (void *pArg)
 void doU1txTask (void *pArg)
 {
     for (;;) {
-        while (Serial.availableForWrite () && !u1tx.isEmpty ())
-            Serial.write (u1tx.dequeue ());
+        refill (u1tx, u1txRefill);
+        if (Serial.availableForWrite () && !u1tx.isEmpty ()) {
+            while (Serial.availableForWrite () && !u1tx.isEmpty ())
+                Serial.write (u1tx.dequeue ());
+            xTaskNotifyGive (emulatorTask);
+        }
         delay (1);
     }
 }
+#endif
+
+// Write the number of values in a FIFO followed by the values
+bool saveFifo (Stream &stream, const Fifo<32> &fifo)
+{
+    uint8_t count = fifo.count ();
+
+    if (stream.write (&count, 1) != 1) return (false);
+    for (uint8_t index = 0; index < count; ++index)
+        if (stream.write (fifo.peek (index)) != 1) return (false);
+    return (true);
+}
+
+// Read the values saved for a FIFO and wait while the task on its device
+// side puts them in place. Called by the processor's task once the device
+// tasks are running.
+bool restoreFifo (Stream &stream, Refill &refill)
+{
+    uint8_t count;
+    uint8_t value;
+
+    if (stream.readBytes (&count, 1) != 1) return (false);
+    refill.count = 0;
+    while (count--) {
+        if (stream.readBytes (&value, 1) != 1) return (false);
+        if (refill.count < sizeof (refill.data)) refill.data [refill.count++] = value;
+    }
+
+    refill.pending.store (true, std::memory_order_release);
+    while (refill.pending.load (std::memory_order_acquire))
+        ulTaskNotifyTake (pdTRUE, 1);
+    return (true);
+}
+
+// Return a page of the expansion pool, allocating and clearing it the first
+// time it is used. Returns NULL if there is no memory for it.
+uint8_t *pageOf (uint16_t page)
+{
+    if (!pool [page]) {
+        uint8_t *pPage = (uint8_t *) heap_caps_malloc (BLOCK_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+
+        if (!pPage && !(pPage = (uint8_t *) malloc (BLOCK_SIZE))) return (NULL);
+        pool [page] = (uint8_t *) memset (pPage, 0, BLOCK_SIZE);
+    }
+    return (pool [page]);
+}
+
+// Map a page of the expansion pool into a block of the window. The block's
+// own RAM, or the page mapped there before, is replaced and the RAM's
+// contents are lost. Returns false if the page or block does not exist,
+// there is no memory for the page or it is mapped into another block.
+bool mapPage (uint16_t page, uint16_t block)
+{
+    if ((page >= POOL_PAGES) || (block >= WINDOW_BLOCKS) || !pageOf (page)) return (false);
+    if (!Memory::remap (WINDOW_BASE + block * BLOCK_SIZE, pool [page])) return (false);
+
+    window [block] = page;
+    return (true);
+}
+
+// Write the page mapped into each window block followed by every allocated
+// pool page, each preceded by its number, ending with a page number of
+// $FFFF. The pages mapped into the window are also in the RAM saved by the
+// emulator but it is the pool's copy that is restored.
+bool saveWindow (Stream &stream)
+{
+    uint8_t bytes [2];
+
+    for (int block = 0; block < WINDOW_BLOCKS; ++block) {
+        Memory::put (bytes, window [block], 2);
+        if (stream.write (bytes, 2) != 2) return (false);
+    }
+    for (int page = 0; page < POOL_PAGES; ++page) {
+        if (!pool [page]) continue;
+
+        Memory::put (bytes, page, 2);
+        if ((stream.write (bytes, 2) != 2) || (stream.write (pool [page], BLOCK_SIZE) != BLOCK_SIZE))
+            return (false);
+    }
+    Memory::put (bytes, 0xffff, 2);
+    return (stream.write (bytes, 2) == 2);
+}
+
+// Map the pages saved by saveWindow back into the window and restore the
+// pool's contents. The emulator has already restored the window's RAM
+// through the pages that were mapped before, so a block that had no page
+// when saved gets its own RAM back holding what was restored into the old
+// page. Every block whose page changes is unmapped before any are mapped so
+// that a page can move between blocks. Pool pages that were not saved are
+// cleared.
+bool restoreWindow (Stream &stream)
+{
+    uint16_t saved [WINDOW_BLOCKS];
+    uint8_t bytes [2];
+    uint32_t value;
+
+    for (int block = 0; block < WINDOW_BLOCKS; ++block) {
+        if (stream.readBytes (bytes, 2) != 2) return (false);
+        Memory::get (bytes, value, 2);
+        if ((value != 0xffff) && (value >= POOL_PAGES)) return (false);
+        saved [block] = value;
+    }
+
+    for (int block = 0; block < WINDOW_BLOCKS; ++block) {
+        uint32_t address = WINDOW_BASE + block * BLOCK_SIZE;
+
+        if ((window [block] == 0xffff) || (window [block] == saved [block])) continue;
+
+        const uint8_t *pOld = pool [window [block]];
+
+        Memory::remap (address, NULL);
+        if (saved [block] == 0xffff)
+            for (uint32_t offset = 0; offset < BLOCK_SIZE; ++offset)
+                Memory::setByte (address + offset, pOld [offset]);
+        window [block] = 0xffff;
+    }
+
+    for (int block = 0; block < WINDOW_BLOCKS; ++block)
+        if ((saved [block] != 0xffff) && (window [block] != saved [block]) && !mapPage (saved [block], block))
+            return (false);
+
+    for (int page = 0; page < POOL_PAGES; ++page)
+        if (pool [page]) memset (pool [page], 0, BLOCK_SIZE);
+
+    for (;;) {
+        if (stream.readBytes (bytes, 2) != 2) return (false);
+        Memory::get (bytes, value, 2);
+        if (value == 0xffff) return (true);
+        if ((value >= POOL_PAGES) || !pageOf (value)) return (false);
+        if (stream.readBytes (pool [value], BLOCK_SIZE) != BLOCK_SIZE) return (false);
+    }
+}
+
+// Save the machine to a stream (e.g. a SPIFFS file) so that it can be
+// resumed later without rebooting and reloading programs.
+bool saveState (Stream &stream)
+{
+    return (emulator.save (stream) && saveWindow (stream)
+        && saveFifo (stream, u1rx) && saveFifo (stream, u1tx));
+}
+
+// Resume a machine saved by saveState. The file must be seekable as the
+// RAM is checked before it is read. A file whose processor state or RAM
+// does not match leaves the machine as it was, but the machine should be
+// reset if the window, pool or FIFOs that follow them fail.
+bool restoreState (File &file)
+{
+    return (emulator.restore (file) && restoreWindow (file)
+        && restoreFifo (file, u1rxRefill) && restoreFifo (file, u1txRefill));
+}
+
+// Save the machine to the state file, replacing the last one. A file that
+// could not be completed is removed.
+bool saveFile (void)
+{
+    File file = SPIFFS.open (STATE_FILE, FILE_WRITE);
+
+    if (!file) return (false);
+
+    bool saved = saveState (file);
+
+    file.close ();
+    if (!saved) SPIFFS.remove (STATE_FILE);
+    return (saved);
+}
+
+// Resume the machine from the state file if there is one. Called once the
+// device tasks are running as they put back the FIFO contents. A rejected
+// file leaves the machine to boot as normal.
+void resumeFile (void)
+{
+    if (!SPIFFS.exists (STATE_FILE)) return;
+
+    File file = SPIFFS.open (STATE_FILE, FILE_READ);
+
+    if (file && restoreState (file))
+        Serial.println (">> Resumed saved state");
+    else {
+        Serial.println ("!! Saved state rejected");
+        emulator.reset ();
+    }
+    file.close ();
+}
 
 void setup (void)
 {
@@ -105,53 +519,141 @@ void setup (void)
     Memory::add (0x00f000, boot, sizeof(boot));              // ROM (4K)
     Memory::add (0x010000, video.data, sizeof(video.data));  // RAM (64K)
     Memory::add (0x020000, 0x020000);                        // RAM (128K)
-    Memory::add (0x040000, code, sizeof (code));             // ROM (256K)
+    Memory::add (0x040000, rom0);                            // ROM (64K)
+    Memory::add (0x050000, rom1);                            // ROM (64K)
+    Memory::add (0x060000, rom2);                            // ROM (64K)
+    Memory::add (0x070000, rom3);                            // ROM (64K)
+
+    for (int block = 0; block < WINDOW_BLOCKS; ++block)
+        window [block] = 0xffff;
 
     Serial.printf (">> Remaining Heap: %d\n", ESP.getFreeHeap ());
     Serial.println (">> Booting");
 
-    xTaskCreatePinnedToCore (doTimerTask, "Timer", 1024, NULL, 1, &timerTask, 0);
-    xTaskCreatePinnedToCore (doU1rxTask, "U1RX", 1024, NULL, 1, &u1rxTask, 0);
-    xTaskCreatePinnedToCore (doU1txTask, "U1TX", 1024, NULL, 1, &u1txTask, 0);
+    scheduler.schedule (TIMER_CYCLES, onTimer);
+    scheduler.schedule (0, onUart);
+    scheduler.schedule (PACE_CYCLES, onPace);
+    scheduler.advance (0);
 
-    Emulator::reset ();
+    emulator.reset ();
 
     cycles = 0;
-    start = micros ();
+    instructions = 0;
+    start = deadline = sampled = micros ();
+
+    emulatorTask = xTaskGetCurrentTaskHandle ();
+#if SPLIT_CORES
+    pacedAt = start;
+    xTaskCreatePinnedToCore (doDevicesTask, "DEVS", 4096, NULL, 1, &devicesTask, 0);
+#else
+    xTaskCreatePinnedToCore (doU1rxTask, "U1RX", 1024, NULL, 1, &u1rxTask, 0);
+    xTaskCreatePinnedToCore (doU1txTask, "U1TX", 1024, NULL, 1, &u1txTask, 0);
+#endif
+
+    if (SPIFFS.begin (true))
+        resumeFile ();
+    else
+        Serial.println ("!! SPIFFS not available");
 }
 
 void loop (void)
 {
-    register int        count = 1024;
+    // Stop when the processor executes STP or the RAM has run out, in which
+    // case a guest write has been lost
+    if (emulator.isStopped () || Memory::exhausted) {
+        delta = micros () - start;
+
+        Serial.printf ("\n\nInstructions = %d Cycles = %d Executed = %d uSec = %d freq = ",
+            instructions, cycles, (uint32_t) executed, delta);
+
+        double speed = executed / (delta * 1e-6);
+
+        if (speed < 1000)
+            Serial.printf ("%f Hz\n", speed);
+        else if ((speed /= 1000) < 1000)
+            Serial.printf ("%f kHz\n", speed);
+        else
+            Serial.printf ("%f MHz\n", speed / 1000);
+
+        Serial.printf ("RAM Fast = %d blocks %d hits Slow = %d blocks %d hits Moves = %d/%d\n",
+            Memory::tiers.fastBlocks, Memory::tiers.fastHits,
+            Memory::tiers.slowBlocks, Memory::tiers.slowHits,
+            Memory::tiers.promotions, Memory::tiers.demotions);
+
+        for (int source = 0; source < INT_SOURCES; ++source) {
+            const Latency &latency = emulator.latency (source);
+
+            Serial.printf ("IRQ %d latency worst = %d cycles:", source, latency.worst);
+            for (int bucket = 0; bucket < LATENCY_BUCKETS; ++bucket)
+                Serial.printf (" %d", latency.count [bucket]);
+            Serial.println ();
+        }
 
-    do {
-       if (Emulator::isStopped ()) {
-            delta = micros () - start;
+        for (;;) delay (1000);
+    }
 
-            Serial.printf ("\n\nCycles = %d uSec = %d freq = ", cycles, delta);
+#if SPLIT_CORES
+    // The processor runs up to the horizon set by the devices, wakes them
+    // and then sleeps until they move it on. A processor waiting for an
+    // interrupt reaches the horizon at once, so it sleeps too. The UART
+    // flags are sampled here when the devices ask.
+    if (uartDue.exchange (false, std::memory_order_acquire)) sampleUart ();
 
-            double speed = cycles / (delta * 1e-6);
+    int32_t room = horizon.load (std::memory_order_acquire) - emulator.now ();
 
-            if (speed < 1000)
-                Serial.printf ("%f Hz\n", speed);
-            else if ((speed /= 1000) < 1000)
-                Serial.printf ("%f kHz\n", speed);
-            else
-                Serial.printf ("%f MHz\n", speed / 1000);
+    if (room <= 0) {
+        xTaskNotifyGive (devicesTask);
+        ulTaskNotifyTake (pdTRUE, 1);
+        return;
+    }
+
+    Slice slice = emulator.run ((room < RUN_CYCLES) ? room : RUN_CYCLES);
+#else
+    // A paced CPU waiting for an interrupt parks the task until the next
+    // event is due or a UART task notifies it of new data, then credits the
+    // time it slept as cycles.
+    if (!turbo && emulator.isWaiting ()) {
+        uint32_t due = scheduler.until (frequency);
+        uint32_t wait = (uint64_t) due * 1000 / frequency;
+        uint32_t idle = due;
+
+        if (wait) {
+            uint32_t slept = micros ();
+
+            ulTaskNotifyTake (pdTRUE, pdMS_TO_TICKS (wait));
+            idle = (uint64_t)(micros () - slept) * frequency / 1000000;
+            if (idle > due) idle = due;
+        }
+        scheduler.advance (idle);
+        emulator.idle (idle);
+        cycles += idle;
+        sampleUart ();
+        return;
+    }
 
-            for (;;) delay (1000);
-       }
-       else {
-            Emulator::ifr.u1rx = !u1rx.isEmpty ();
-            Emulator::ifr.u1tx = !u1tx.isFull (); 
+    // Run until the next device event is due, the budget is used or the CPU
+    // needs attention, then fire any events that are now due.
+    Slice slice = emulator.run (scheduler.until (RUN_CYCLES));
 
-            cycles += Emulator::step ();
-       }
+    scheduler.advance (slice.cycles);
+#endif
+    cycles += slice.cycles;
+    instructions += slice.instructions;
+    executed.fetch_add (slice.cycles - slice.idle, std::memory_order_relaxed);
 
-    } while (--count);
+    // A save asked for by the processor is made between runs
+    if (saving == SAVE_PENDING) saving = saveFile () ? SAVE_DONE : SAVE_FAILED;
+
+    if (++runs % AGE_RUNS == 0) Memory::age ();
+}
+
+// Limit a count to the 16 bits returned by a WDM call
+static uint16_t saturate (uint32_t value)
+{
+    return ((value < 0xffff) ? value : 0xffff);
 }
 
-uint8_t Common::op_wdm(uint32_t eal, uint32_t eah)
+uint8_t Registers::op_wdm(uint32_t eal, uint32_t eah)
 {
     TRACE(wdm);
 
@@ -163,23 +665,46 @@ uint8_t Common::op_wdm(uint32_t eal, uint32_t eah)
     case 0x02:  ier.f |=  c.w;      break;
     case 0x03:  ier.f &= ~c.w;      break;
 
-    case 0x04:  c.w = ifr.f;        break;
-    case 0x05:  ifr.f = c.w;        break;
-    case 0x06:  ifr.f |=  c.w;      break;
-    case 0x07:  ifr.f &= ~c.w;      break;
+    case 0x04:  c.w = flags ();     break;
+    case 0x05:  setFlags (c.w);     break;
+    case 0x06:  raise (c.w);        break;
+    case 0x07:  lower (c.w);        break;
 
-    case 0x08:  c.w = ier.f & ifr.f; break;
+    case 0x08:  c.w = ier.f & flags (); break;
 
     case 0x10:	{
-            u1tx.enqueue (c.l);
+            if (!u1tx.isFull ()) u1tx.enqueue (c.l);
+            signal (INT_U1TX, !u1tx.isFull ());
             break;
         }
     case 0x11:	{
-            c.l = u1rx.dequeue ();
+            if (!u1rx.isEmpty ()) c.l = u1rx.dequeue ();
+            signal (INT_U1RX, !u1rx.isEmpty ());
             break;
         }
 
+    case 0x20:  if (!mapPage (c.w, x.w)) c.w = 0xffff; break;
+    case 0x21:  c.w = (x.w < WINDOW_BLOCKS) ? window [x.w] : 0xffff; break;
+    case 0x22:  c.w = POOL_PAGES; break;
+
+    case 0x30:  if (c.w) frequency = ((c.w < MAX_CLOCK) ? c.w : MAX_CLOCK) * 1000000; turbo = !c.w; break;
+    case 0x31:  c.w = saturate (speed); break;
+
+    case 0x40:  {
+            if ((x.w < INT_SOURCES) && (y.w < LATENCY_BUCKETS))
+                c.w = saturate (latency (x.w).count [y.w]);
+            else
+                c.w = 0xffff;
+            break;
+        }
+    case 0x41:  c.w = (x.w < INT_SOURCES) ? saturate (latency (x.w).worst) : 0xffff; break;
+    case 0x42:  clearLatency (); break;
+
+    case 0x50:  saving = SAVE_PENDING; break;
+    case 0x51:  c.w = saving; break;
+    case 0x52:  c.w = SPIFFS.remove (STATE_FILE) ? 0 : 0xffff; break;
+
     case 0x80:  Trace::enable (true); break;
     }
-    return (3);
+    return (0);
 }
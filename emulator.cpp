@@ -29,34 +29,14 @@
 
 #include "Emulator.h"
 
+#include <FS.h>
+
 //==============================================================================
 // Registers & State
 //------------------------------------------------------------------------------
 
-Word		Registers::pc;
-Word		Registers::sp;
-Word		Registers::dp;
-Word		Registers::c;
-Word		Registers::x;
-Word		Registers::y;
-Address		Registers::pbr;
-Address		Registers::dbr;
-Flags		Registers::p;
-
-bool		Registers::e;
-
-Interrupts	Registers::ier;
-volatile Interrupts	Registers::ifr;
-
-bool		Registers::stopped = true;
-bool		Registers::interrupted;
-bool		Registers::waiting;
-
-const OpcodeSet *Registers::pOpcodeSet;
-
-//------------------------------------------------------------------------------
-
-void Emulator::setMode(void)
+// Select the opcode set that matches the E, M and X bits.
+void Registers::setMode(void)
 {
 	if (e) {
 		pOpcodeSet = &CpuModeE11::opcodeSet;
@@ -75,6 +55,103 @@ void Emulator::setMode(void)
 	}
 }
 
+// Called on entering a block that only reads memory and branches back to
+// itself. If a whole pass has left the registers unchanged the loop can only
+// exit after an interrupt, so the rest of the budget is skipped in whole
+// passes. Returns true if the run should end.
+//
+// A pass that read from a device (e.g. polling a UART status register) is
+// never skipped as the device may change without any register changing.
+// The budget ends at the next device event or the horizon set by the
+// devices core, and a pending interrupt ends the run without a skip.
+bool Registers::isIdle(const Block *pBlock, Slice &slice, uint32_t budget)
+{
+	if ((loop.pBlock == pBlock) && (slice.instructions - loop.instructions == pBlock->count)
+			&& (loop.c == c.w) && (loop.x == x.w) && (loop.y == y.w)
+			&& (loop.sp == sp.w) && (loop.dp == dp.w) && (loop.dbr == dbr.b)
+#if LAZY_FLAGS
+			&& (loop.nz == nz)
+#endif
+			&& (loop.p == p.f) && (loop.deviceReads == Memory::deviceReads)
+			&& (slice.cycles < budget)) {
+		if (!(ier.f & flags()) || p.i) {
+			register uint32_t	pass = slice.cycles - loop.cycles;
+			register uint32_t	passes = (budget - slice.cycles + pass - 1) / pass;
+
+			slice.cycles += passes * pass;
+			slice.idle += passes * pass;
+			slice.instructions += passes * pBlock->count;
+		}
+		loop.pBlock = NULL;
+		remaining = 0;
+		return (true);
+	}
+
+	loop.pBlock = pBlock;
+	loop.cycles = slice.cycles;
+	loop.instructions = slice.instructions;
+	loop.c = c.w;
+	loop.x = x.w;
+	loop.y = y.w;
+	loop.sp = sp.w;
+	loop.dp = dp.w;
+	loop.dbr = dbr.b;
+	loop.p = p.f;
+#if LAZY_FLAGS
+	loop.nz = nz;
+#endif
+	loop.deviceReads = Memory::deviceReads;
+	return (false);
+}
+
+// Note the time that interrupt flags went from clear to raised, counting
+// the cycles already spent in the current run. A WDM always starts a block
+// so these are exact for a flag raised by the processor itself.
+void Registers::rose(uint16_t mask)
+{
+	register uint32_t	time = elapsed.load(std::memory_order_acquire);
+
+	time += spent.load(std::memory_order_relaxed);
+	for (register uint16_t source = 0; source < INT_SOURCES; ++source)
+		if (mask & (1 << source)) raised[source].store(time, std::memory_order_relaxed);
+}
+
+// Called as the IRQ is taken. Adds the latency of each enabled source that
+// has been raised since the last IRQ to its histogram. The raise times are
+// claimed with an exchange as a device on another core may be setting them.
+void Registers::taken(void)
+{
+	register uint16_t	pending = ier.f & flags();
+
+	for (register uint16_t source = 0; source < INT_SOURCES; ++source) {
+		if (!(pending & (1 << source))) continue;
+
+		register uint32_t	when = raised[source].exchange(NOT_RAISED, std::memory_order_relaxed);
+
+		if (when == NOT_RAISED) continue;
+
+		register uint32_t	delay = now() - when;
+		register Latency	&latency = latencies[source];
+		register uint16_t	bucket = 0;
+
+		while ((bucket < LATENCY_BUCKETS - 1) && (((uint64_t) delay + 1) >> (bucket + 1)))
+			++bucket;
+		++latency.count[bucket];
+		if (delay > latency.worst) latency.worst = delay;
+	}
+}
+
+// Empty the latency histograms and forget any pending raises
+void Registers::clearLatency(void)
+{
+	for (register uint16_t source = 0; source < INT_SOURCES; ++source) {
+		raised[source].store(NOT_RAISED, std::memory_order_relaxed);
+		for (register uint16_t bucket = 0; bucket < LATENCY_BUCKETS; ++bucket)
+			latencies[source].count[bucket] = 0;
+		latencies[source].worst = 0;
+	}
+}
+
 void Emulator::reset(void)
 {
 	pc.w = Memory::getWord(0xfffc, 0xfffd);
@@ -84,6 +161,7 @@ void Emulator::reset(void)
 	p.d = 0;
 	p.m = 1;
 	p.x = 1;
+	setp(p.f);
 	pbr.a = 0;
 	dbr.a = 0;
 	e = true;
@@ -91,6 +169,113 @@ void Emulator::reset(void)
 	stopped = false;
 	interrupted = false;
 	waiting = false;
+	remaining = 0;
+
+	cache.flush();
+	setMode();
+}
+// Start this emulator from a copy of another's processor state, usually to
+// run a memory image forked from the other's. Decoded code is not copied.
+void Emulator::fork(const Emulator &parent)
+{
+	pc = parent.pc;
+	sp = parent.sp;
+	dp = parent.dp;
+	c = parent.c;
+	x = parent.x;
+	y = parent.y;
+	pbr = parent.pbr;
+	dbr = parent.dbr;
+	p = parent.p;
+	e = parent.e;
+#if LAZY_FLAGS
+	nz = parent.nz;
+#endif
+	ier = parent.ier;
+	setFlags(parent.flags());
 
+	stopped = parent.stopped;
+	interrupted = parent.interrupted;
+	waiting = parent.waiting;
+	remaining = 0;
+	loop.pBlock = NULL;
+
+	cache.flush();
 	setMode();
-}
\ No newline at end of file
+}
+
+//==============================================================================
+// Saved State
+//------------------------------------------------------------------------------
+
+// Write the processor state followed by the contents of the RAM to a
+// stream. The state starts with an identity and format version so that it
+// can be checked when restored. Returns false if the stream fails.
+bool Emulator::save(Stream &stream)
+{
+	uint8_t			state[27];
+	register uint8_t	*pState = state;
+
+	pState = Memory::put(pState, STATE_MAGIC, 4);
+	pState = Memory::put(pState, STATE_VERSION, 2);
+	pState = Memory::put(pState, pc.w, 2);
+	pState = Memory::put(pState, sp.w, 2);
+	pState = Memory::put(pState, dp.w, 2);
+	pState = Memory::put(pState, c.w, 2);
+	pState = Memory::put(pState, x.w, 2);
+	pState = Memory::put(pState, y.w, 2);
+	pState = Memory::put(pState, pbr.b, 1);
+	pState = Memory::put(pState, dbr.b, 1);
+	pState = Memory::put(pState, getp(), 1);
+	pState = Memory::put(pState, e, 1);
+	pState = Memory::put(pState, ier.f, 2);
+	pState = Memory::put(pState, flags(), 2);
+	pState = Memory::put(pState, stopped | interrupted << 1 | waiting << 2, 1);
+
+	if (stream.write(state, sizeof(state)) != sizeof(state)) return (false);
+	return (Memory::save(stream));
+}
+
+// Replace the processor state and RAM contents with those read from a
+// file. The opcode set is selected again from the restored E, M and X bits
+// and all decoded code is discarded. Returns false if the state has the
+// wrong identity or version, is truncated or corrupt or does not match the
+// memory map, in which case the machine is left as it was, or if the file
+// fails while the RAM is being read back (see Memory::restore).
+bool Emulator::restore(File &file)
+{
+	uint8_t			state[27];
+	register const uint8_t	*pState = state;
+	uint32_t		value;
+
+	if (file.readBytes(state, sizeof(state)) != sizeof(state)) return (false);
+
+	pState = Memory::get(pState, value, 4);
+	if (value != STATE_MAGIC) return (false);
+	pState = Memory::get(pState, value, 2);
+	if (value != STATE_VERSION) return (false);
+	if (!Memory::restore(file)) return (false);
+
+	pState = Memory::get(pState, value, 2);	pc.w = value;
+	pState = Memory::get(pState, value, 2);	sp.w = value;
+	pState = Memory::get(pState, value, 2);	dp.w = value;
+	pState = Memory::get(pState, value, 2);	c.w = value;
+	pState = Memory::get(pState, value, 2);	x.w = value;
+	pState = Memory::get(pState, value, 2);	y.w = value;
+	pState = Memory::get(pState, value, 1);	pbr.a = value << 16;
+	pState = Memory::get(pState, value, 1);	dbr.a = value << 16;
+	pState = Memory::get(pState, value, 1);	setp(value);
+	pState = Memory::get(pState, value, 1);	e = value;
+	pState = Memory::get(pState, value, 2);	ier.f = value;
+	pState = Memory::get(pState, value, 2);	setFlags(value);
+	pState = Memory::get(pState, value, 1);
+	stopped = value & 1;
+	interrupted = value & 2;
+	waiting = value & 4;
+
+	remaining = 0;
+	loop.pBlock = NULL;
+	cache.flush();
+	setMode();
+	return (true);
+}
@@ -27,21 +27,24 @@
 #define EMULATOR_H
 
 #include <stdint.h>
+#include <atomic>
 #include <iostream>
 
 using namespace std;
 
 #include "Memory.h"
 
+class Stream;
+
 //==============================================================================
 // Macros
 //------------------------------------------------------------------------------
 
 #if 0
-#define SHOW_PC()		Trace::start()
+#define SHOW_PC()		Trace::start(*this)
 #define SHOW_CY(CY)		Trace::cycles(CY)
-#define BYTES(NM)		Trace::bytes(NM)
-#define TRACE(OP)		Trace::trace (#OP, eal, eah)
+#define BYTES(NM)		Trace::bytes(*this, NM)
+#define TRACE(OP)		Trace::trace (*this, #OP, eal, eah)
 
 #define CLK_FREQ		1
 #else
@@ -53,6 +56,28 @@ using namespace std;
 #define CLK_FREQ		100
 #endif
 
+// Set to 1 to run instructions with the threaded interpreter loops or to 0
+// to call the opcode functions through the OpcodeSet tables.
+#define THREADED		1
+
+// Set to 1 to hold the last result and only work out the N and Z flags from
+// it when they are read or to 0 to update them after every operation.
+#define LAZY_FLAGS		1
+
+// Set to 1 to add the conditional cycle penalties (unaligned direct page,
+// index crossing a page, branch taken) to each opcode's fixed cycles or to
+// 0 to count only the fixed cycles.
+#define CYCLE_EXACT		1
+
+// The most bytes an MVN or MVP moves in one dispatch. Interrupts are only
+// checked between dispatches so this bounds the latency a long move adds.
+#define MOVE_BYTES		256
+
+// The identity and format version written at the start of a saved state.
+// The version must change whenever the layout of the state does.
+#define STATE_MAGIC		0x36313845
+#define STATE_VERSION	3
+
 //==============================================================================
 // Data Types
 //------------------------------------------------------------------------------
@@ -100,146 +125,541 @@ union Interrupts {
 	uint16_t			f;
 };
 
+// The interrupt sources as masks of their bits in IER and IFR
+#define INT_TMR			0x0001
+#define INT_U1RX		0x0002
+#define INT_U1TX		0x0004
+
+// The number of interrupt sources whose latency is measured and the buckets
+// in each histogram. Bucket n counts latencies from 2^n - 1 to 2^(n+1) - 2
+// cycles and the last also counts all the longer ones.
+#define INT_SOURCES		3
+#define LATENCY_BUCKETS	16
+
+// The raise time of a source that is not waiting to be taken
+#define NOT_RAISED		UINT32_MAX
+
+// The cycles between an interrupt source raising its flag and the processor
+// taking the IRQ, as a histogram and the worst seen
+struct Latency {
+	uint32_t			count[LATENCY_BUCKETS];
+	uint32_t			worst;
+};
+
+// The number of cycles and instructions executed by a run, and how many of
+// the cycles were skipped in an idle loop or while waiting rather than
+// actually executed
+struct Slice {
+	uint32_t			cycles;
+	uint32_t			instructions;
+	uint32_t			idle;
+};
+
+// The cycle counting policies. The cycle-exact policy adds the penalties
+// reported by an opcode's addressing mode and operation, the fast policy
+// discards them so that every opcode costs a constant.
+template<bool EXACT>
+struct CyclePolicy {
+	static constexpr uint8_t extra(uint8_t cycles) { return (cycles); }
+};
+
+template<>
+struct CyclePolicy<false> {
+	static constexpr uint8_t extra(uint8_t cycles) { return (0); }
+};
+
+typedef CyclePolicy<CYCLE_EXACT> Cycles;
+
 //==============================================================================
 // Opcode Function Table
 //------------------------------------------------------------------------------
 
+class Registers;
+class Emulator;
+
 // A pointer to a opcode executing function
-typedef uint8_t(*Opcode)(void);
+typedef uint8_t(Emulator::*Opcode)(void);
+
+// A pointer to a threaded loop that executes opcodes for one mode
+typedef bool(Emulator::*Execute)(Slice &slice, uint32_t budget);
 
 // A set of pointers to functions that execution opcodes and interrupts
 struct OpcodeSet {
 	const Opcode		pIrq;
 	const Opcode		pNmi;
 	const Opcode		pAbort;
+	const Execute		pExecute;
 	const Opcode		pOpcode[256];
+	const uint8_t		length[256];
+};
+
+//==============================================================================
+// Decoded Instruction Cache
+//------------------------------------------------------------------------------
+
+// The number of blocks held in the cache (MUST be a power of 2)
+#define CACHE_BLOCKS		128
+
+// The maximum number of instructions and bytes in a block
+#define CACHE_INSNS			8
+#define CACHE_BYTES			32
+
+// The number of successor blocks remembered for each block
+#define CACHE_LINKS			2
+
+// Set to 1 to follow the links from the last block returned before looking
+// up the cache or to 0 to look up every block.
+#ifndef BLOCK_CHAINING
+#define BLOCK_CHAINING		1
+#endif
+
+// Pairs of opcodes that the threaded interpreter runs as one fused
+// instruction when they are decoded next to each other in a block.
+#define ALL_FUSIONS(FUSE) \
+	FUSE(18, 65) FUSE(18, 69) FUSE(18, 6d) FUSE(18, 6f) FUSE(18, 79) FUSE(18, 7d) \
+	FUSE(38, e5) FUSE(38, e9) FUSE(38, ed) FUSE(38, ef) FUSE(38, f9) FUSE(38, fd) \
+	FUSE(a5, 85) FUSE(a5, 8d) FUSE(a9, 85) FUSE(a9, 8d) FUSE(ad, 85) FUSE(ad, 8d) \
+	FUSE(af, 8f) FUSE(b1, 91) FUSE(b7, 97) FUSE(b9, 99) FUSE(bd, 9d) \
+	FUSE(88, d0) FUSE(ca, d0) FUSE(c8, d0) FUSE(e8, d0) FUSE(e6, d0) FUSE(ee, d0) \
+	FUSE(c5, d0) FUSE(c5, f0) FUSE(c9, d0) FUSE(c9, f0) FUSE(cd, d0) FUSE(cd, f0) \
+	FUSE(cf, d0) FUSE(cf, f0) FUSE(29, d0) FUSE(29, f0) \
+	FUSE(c2, e2) FUSE(e2, c2)
+
+// The dispatch codes of fused pairs follow the 256 single opcodes
+#define FUSE_CODE(A,B)		FUSE_##A##_##B,
+
+enum {
+	ALL_FUSIONS(FUSE_CODE)
+	FUSIONS
+};
+
+#define FUSED_BASE			256
+
+// A straight-line run of instructions decoded with a specific opcode set
+struct Block {
+	uint32_t			address;
+	uint32_t			last;
+	uint32_t			version[2];
+	const OpcodeSet		*pOpcodeSet;
+	uint8_t				count;
+	uint8_t				slot;
+	bool				idle;
+	uint32_t			linked;
+	Block				*pLink[CACHE_LINKS];
+	Opcode				pOpcode[CACHE_INSNS];
+	uint16_t			code[CACHE_INSNS];
+	uint8_t				bytes[CACHE_BYTES];
+};
+
+class Cache
+{
+private:
+	Block				blocks[CACHE_BLOCKS];
+	Block				*pLast;
+
+	void decode(Block &block, uint32_t address, const OpcodeSet *pOpcodeSet);
+
+public:
+	Cache(void)
+	{
+		flush();
+	}
+
+	void flush(void);
+
+	// Return the block starting at the address, decoding it if the cached
+	// copy is missing, was built for another mode or its memory has changed.
+	//
+	// The blocks that followed the last one returned are linked to it. A
+	// link is only followed if no watched memory has been written since it
+	// was made, so the linked block needs no version checks.
+	const Block *lookup(uint32_t address, const OpcodeSet *pOpcodeSet)
+	{
+#if BLOCK_CHAINING
+		register Block *pFrom = pLast;
+
+		if (pFrom->linked == Memory::generation) {
+			for (register int index = 0; index < CACHE_LINKS; ++index) {
+				register Block *pLink = pFrom->pLink[index];
+
+				if (pLink && (pLink->address == address) && (pLink->pOpcodeSet == pOpcodeSet))
+					return (pLast = pLink);
+			}
+		}
+		else {
+			for (register int index = 0; index < CACHE_LINKS; ++index)
+				pFrom->pLink[index] = NULL;
+			pFrom->linked = Memory::generation;
+		}
+#endif
+
+		register Block &block = blocks[(address ^ (address >> 8)) & (CACHE_BLOCKS - 1)];
+
+		if ((block.address != address) || (block.pOpcodeSet != pOpcodeSet)
+				|| (block.version[0] != Memory::versionOf(block.address))
+				|| (block.version[1] != Memory::versionOf(block.last)))
+			decode(block, address, pOpcodeSet);
+
+#if BLOCK_CHAINING
+		pFrom->pLink[pFrom->slot] = &block;
+		pFrom->slot = (pFrom->slot + 1) % CACHE_LINKS;
+#endif
+
+		return (pLast = &block);
+	}
 };
 
 //==============================================================================
 // Registers
 //------------------------------------------------------------------------------
 
-// The 65C816's register set and state variables
-class Registers
+// The state at the start of the last pass through an idle loop block
+struct Loop {
+	const Block			*pBlock;
+	uint32_t			cycles;
+	uint32_t			instructions;
+	uint16_t			c;
+	uint16_t			x;
+	uint16_t			y;
+	uint16_t			sp;
+	uint16_t			dp;
+	uint8_t				dbr;
+	uint8_t				p;
+#if LAZY_FLAGS
+	uint32_t			nz;
+#endif
+	uint32_t			deviceReads;
+};
+
+// The 65C816's register set and state variables. Each emulator instance has
+// its own copy which the opcode functions reach through 'this'. The values
+// used by every instruction are placed together in the first cache line.
+class alignas(64) Registers
 {
+	friend class Trace;
 protected:
-	static Word			pc;
-	static Word			sp;
-	static Word			dp;
-	static Word			c;
-	static Word			x;
-	static Word			y;
-	static Address		pbr;
-	static Address		dbr;
-	static Flags		p;
-	static bool			e;
+	Word				pc;
+	Word				sp;
+	Word				dp;
+	Word				c;
+	Word				x;
+	Word				y;
+	Address				pbr;
+	Address				dbr;
+	Flags				p;
+	bool				e;
+#if LAZY_FLAGS
+	uint32_t			nz;
+#endif
+
+	uint8_t				remaining;
+	const uint8_t		*pFetch;
+	const Block			*pBlock;
+	const OpcodeSet		*pOpcodeSet;
+	uint32_t			generation;
+	uint32_t			owed;
+
+	Interrupts			ier;
+	std::atomic<uint16_t>	ifr;
 
-	static const OpcodeSet *pOpcodeSet;
+	bool				stopped;
+	bool				interrupted;
+	bool				waiting;
 
-	static Interrupts	ier;
+	Loop				loop;
+	Cache				cache;
 
-	static bool			stopped;
-	static bool			interrupted;
-	static bool			waiting;
+	std::atomic<uint32_t>	elapsed;
+	std::atomic<uint32_t>	spent;
+	std::atomic<uint32_t>	raised[INT_SOURCES];
+	Latency				latencies[INT_SOURCES];
 
-	Registers(void) { }
+	Registers(void)
+		: remaining(0), owed(0), stopped(true), interrupted(false), waiting(false)
+	{
+		ier.f = 0;
+		ifr.store(0, std::memory_order_relaxed);
+		elapsed.store(0, std::memory_order_relaxed);
+		spent.store(0, std::memory_order_relaxed);
+		clearLatency();
+	}
+
+	void setMode(void);
 
 	// Set the Carry bit
-	static void setc(bool v)
+	void setc(bool v)
 	{
 		p.c = v ? 1 : 0;
 	}
 
 	// Set the Zero bit
-	static void setz(bool v)
+	void setz(bool v)
 	{
+#if LAZY_FLAGS
+		nz = (getn() ? 0x10000 : 0) | (v ? 0 : 1);
+#else
 		p.z = v ? 1 : 0;
+#endif
 	}
 
 	// Set the Interrupt Disable bit
-	static void seti(bool v)
+	void seti(bool v)
 	{
 		p.i = v ? 1 : 0;
 	}
 
 	// Set the Decimal Arithmetic bit
-	static void setd(bool v)
+	void setd(bool v)
 	{
 		p.d = v ? 1 : 0;
 	}
 
 	// Set the Overflow bit
-	static void setv(bool v)
+	void setv(bool v)
 	{
 		p.v = v ? 1 : 0;
 	}
 
 	// Set the Negative bit
-	static void setn(bool v)
+	void setn(bool v)
 	{
+#if LAZY_FLAGS
+		nz = (v ? 0x10000 : 0) | (getz() ? 0 : 1);
+#else
 		p.n = v ? 1 : 0;
+#endif
 	}
 
+#if LAZY_FLAGS
+	// With lazy flags the last result is held in the low 16 bits of nz with
+	// its sign in bit 15, so bytes are shifted up. N is the OR of bits 15 and
+	// 16, and Z is set when the low 16 bits are all zero. Bit 16 lets N be
+	// set while Z is also set.
+
 	// Set the Negative and Zero flags to match an 8-bit value
-	static void setnz_b(uint8_t v)
+	void setnz_b(uint8_t v)
+	{
+		nz = v << 8;
+	}
+
+	// Set the Negative and Zero flags to match a 16-bit value
+	void setnz_w(uint16_t v)
+	{
+		nz = v;
+	}
+
+	// Return the state of the Negative bit
+	bool getn(void) const
+	{
+		return (nz & 0x18000);
+	}
+
+	// Return the state of the Zero bit
+	bool getz(void) const
+	{
+		return (!(nz & 0xffff));
+	}
+
+	// Return the status byte with the current N and Z flags in it
+	uint8_t getp(void)
+	{
+		p.n = getn() ? 1 : 0;
+		p.z = getz() ? 1 : 0;
+		return (p.f);
+	}
+
+	// Replace the status byte and the held N and Z flags
+	void setp(uint8_t f)
+	{
+		p.f = f;
+		nz = (p.n << 16) | (p.z ^ 1);
+	}
+#else
+	// Set the Negative and Zero flags to match an 8-bit value
+	void setnz_b(uint8_t v)
 	{
 		setn(v & 0x80);
 		setz(v == 0x00);
 	}
 
 	// Set the Negative and Zero flags to match a 18-bit value
-	static void setnz_w(uint16_t v)
+	void setnz_w(uint16_t v)
 	{
 		setn(v & 0x8000);
 		setz(v == 0x0000);
 	}
 
+	// Return the state of the Negative bit
+	bool getn(void) const
+	{
+		return (p.n);
+	}
+
+	// Return the state of the Zero bit
+	bool getz(void) const
+	{
+		return (p.z);
+	}
+
+	// Return the status byte
+	uint8_t getp(void)
+	{
+		return (p.f);
+	}
+
+	// Replace the status byte
+	void setp(uint8_t f)
+	{
+		p.f = f;
+	}
+#endif
+
+	// Fetch the next instruction byte from the decoded block
+	uint8_t fetch(void)
+	{
+		++pc.w;
+		return (*pFetch++);
+	}
+
+	// Step over the next instruction byte and return its address
+	uint32_t skip(void)
+	{
+		++pFetch;
+		return (pbr.a | pc.w++);
+	}
+
 	// Get a byte from memory
-	static uint8_t getByte(uint32_t l)
+	uint8_t getByte(uint32_t l)
 	{
 		return (Memory::getByte(l));
 	}
 
 	// Get a word from memory
-	static uint16_t getWord(uint32_t l, uint32_t h)
+	uint16_t getWord(uint32_t l, uint32_t h)
+	{
+		return (Memory::getWord(l, h));
+	}
+
+	// Get a long address from memory
+	uint32_t getLong(uint32_t l, uint32_t h, uint32_t u)
 	{
-		return (getByte(l) | (getByte(h) << 8));
+		return (Memory::getLong(l, h, u));
 	}
 
 	// Set a byte in memory
-	static void setByte(uint32_t l, uint8_t b)
+	void setByte(uint32_t l, uint8_t b)
 	{
 		return (Memory::setByte(l, b));
 	}
 
 	// Set a word in memory
-	static void setWord(uint32_t l, uint32_t h, uint16_t w)
+	void setWord(uint32_t l, uint32_t h, uint16_t w)
 	{
-		setByte(l, w >> 0);
-		setByte(h, w >> 8);
+		Memory::setWord(l, h, w);
 	}
 
 	// Set the emulation as stopped.
-	static void stop(void)
+	void stop(void)
 	{
 		stopped = true;
 	}
 
+	// Perform a WDM call to the virtual peripherals. Defined by the sketch.
+	uint8_t op_wdm(uint32_t eal, uint32_t eah);
+
+	// Determine if a run should end before starting the next block.
+	bool isDone(uint32_t cycles, uint32_t budget)
+	{
+		return ((cycles >= budget) || stopped || waiting
+			|| ((ier.f & flags()) && (p.i == 0)));
+	}
+
+	bool isIdle(const Block *pBlock, Slice &slice, uint32_t budget);
+
+	void rose(uint16_t mask);
+	void taken(void);
+
 public:
-	static volatile Interrupts	ifr;
+	// Return the interrupt flags (IFR). Devices and the processor can read
+	// and update them from any task or core as each change is atomic.
+	uint16_t flags(void) const
+	{
+		return (ifr.load(std::memory_order_relaxed));
+	}
+
+	// Raise the interrupt flags in a mask, noting the time of any that were
+	// not already raised
+	void raise(uint16_t mask)
+	{
+		register uint16_t	rising = mask & ~ifr.fetch_or(mask, std::memory_order_relaxed);
+
+		if (rising) rose(rising);
+	}
+
+	// Lower the interrupt flags in a mask
+	void lower(uint16_t mask)
+	{
+		ifr.fetch_and(~mask, std::memory_order_relaxed);
+	}
+
+	// Raise or lower the interrupt flags in a mask to match a device state
+	void signal(uint16_t mask, bool state)
+	{
+		if (state) raise(mask); else lower(mask);
+	}
+
+	// Replace all the interrupt flags
+	void setFlags(uint16_t value)
+	{
+		register uint16_t	rising = value & ~ifr.exchange(value, std::memory_order_relaxed);
+
+		if (rising) rose(rising);
+	}
+
+	// Count cycles that have passed, including any without the processor
+	// running such as while the emulator slept during a WAI. Only the thread
+	// running the processor may do this. The cycles spent in a run are
+	// cleared first so a raise on another core never counts them twice.
+	void idle(uint32_t cycles)
+	{
+		spent.store(0, std::memory_order_relaxed);
+		elapsed.store(elapsed.load(std::memory_order_relaxed) + cycles, std::memory_order_release);
+	}
+
+	// Return the number of cycles that have passed, modulo 2^32. Devices on
+	// another core use this as the processor's clock.
+	uint32_t now(void) const
+	{
+		return (elapsed.load(std::memory_order_relaxed));
+	}
+
+	// Return the interrupt latency histogram of a source
+	const Latency &latency(uint16_t source) const
+	{
+		return (latencies[source]);
+	}
+
+	void clearLatency(void);
 
 	// Return the state of the stopped flag
-	static bool isStopped(void)
+	bool isStopped(void)
 	{
 		return (stopped);
 	}
+
+	// Determine if the processor is waiting for an interrupt that has not
+	// arrived yet
+	bool isWaiting(void)
+	{
+		return (waiting && !(ier.f & flags()));
+	}
 };
 
 //==============================================================================
 // Trace Utility
 //------------------------------------------------------------------------------
 
-class Trace : public Registers
+class Trace
 {
 private:
 	static bool			enabled;
@@ -254,151 +674,177 @@ public:
 		enabled = state;
 	}
 
-	static void start(void);
-	static void bytes(uint16_t count);
-	static void trace(const char *pOpcode, uint32_t eal, uint32_t eah);
+	static void start(const Registers &r);
+	static void bytes(const Registers &r, uint16_t count);
+	static void trace(const Registers &r, const char *pOpcode, uint32_t eal, uint32_t eah);
 	static void cycles(uint16_t cycles);
 };
 
-//==============================================================================
-// Emulator
-//------------------------------------------------------------------------------
-
-class Emulator : public Registers
-{
-	friend class Common;
-	friend class ModeE;
-	friend class ModeN;
-private:
-	Emulator() { }
-
-	static void setMode(void);
-public:
-
-	static void reset(void);
-
-	static uint8_t step(void)
-	{
-		if (ier.f & ifr.f) {
-			interrupted = true;
-			if (p.i == 0) (*(pOpcodeSet -> pIrq))();
-		}
-
-		SHOW_PC();
-		register uint8_t opcode = Memory::getByte(pbr.a | pc.w++);
-		register uint8_t cycles = ((*(pOpcodeSet->pOpcode[opcode]))());
-		SHOW_CY(cycles);
-		return (cycles);
-	}
-};
-
 //==============================================================================
 // Common Opcodes and Addressing Modes
 //------------------------------------------------------------------------------
 
-class Common : public Registers
+template<class B>
+class Common : public B
 {
 protected:
+	// The fixed cycles of the addressing modes and operations in this class.
+	// Conditional penalties are returned by the functions themselves.
+	enum {
+		am_absi_CY				= 4,
+		am_abxi_CY				= 5,
+		am_abil_CY				= 4,
+		am_alng_CY				= 3,
+		am_alnx_CY				= 3,
+		am_immb_CY				= 0,
+		am_immw_CY				= 0,
+		am_impl_CY				= 0,
+		am_rela_CY				= 1,
+		am_lrel_CY				= 2,
+		op_clc_CY				= 2,
+		op_cld_CY				= 2,
+		op_cli_CY				= 2,
+		op_clv_CY				= 2,
+		op_jml_CY				= 2,
+		op_jmp_CY				= 2,
+		op_nop_CY				= 2,
+		op_sec_CY				= 2,
+		op_sed_CY				= 2,
+		op_sei_CY				= 2,
+		op_stp_CY				= 2,
+		op_tcd_CY				= 2,
+		op_tcs_CY				= 2,
+		op_tdc_CY				= 2,
+		op_tsc_CY				= 2,
+		op_wai_CY				= 2,
+		op_wdm_CY				= 3,
+		op_xba_CY				= 2,
+		op_xce_CY				= 2
+	};
+
+	using B::pc;
+	using B::sp;
+	using B::dp;
+	using B::c;
+	using B::x;
+	using B::pbr;
+	using B::p;
+	using B::e;
+	using B::fetch;
+	using B::getLong;
+	using B::getWord;
+	using B::interrupted;
+	using B::setMode;
+	using B::setc;
+	using B::setd;
+	using B::seti;
+	using B::setnz_b;
+	using B::setnz_w;
+	using B::setv;
+	using B::skip;
+	using B::stop;
+	using B::waiting;
+
 	// Absolute Indirect (JMP only)
-	static uint8_t am_absi(uint32_t &eal, uint32_t &eah)
+	uint8_t am_absi(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		register uint16_t	al = getByte(pbr.a | pc.w++);
-		register uint16_t	ah = getByte(pbr.a | pc.w++);
+		register uint16_t	al = fetch();
+		register uint16_t	ah = fetch();
 
 		al = (ah << 8) | al;
 		ah = al + 1;
 
 		eal = pbr.a | getWord(pbr.a | al, pbr.a | ah);
 		eah = eal + 1;
-		return (4);
+		return (0);
 	}
 
 	// Absolute Indexed by X Indirect (JMP & JSR only)
-	static uint8_t am_abxi(uint32_t &eal, uint32_t &eah)
+	uint8_t am_abxi(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		register uint16_t	al = getByte(pbr.a | pc.w++);
-		register uint16_t	ah = getByte(pbr.a | pc.w++);
+		register uint16_t	al = fetch();
+		register uint16_t	ah = fetch();
 
 		al = (ah << 8) | al + x.w;
 		ah = al + 1;
 
 		eal = pbr.a | getWord(pbr.a | al, pbr.a | ah);
 		eah = eal + 1;
-		return (5);
+		return (0);
 	}
 
 	// Absolute Indirect Long
-	static uint8_t am_abil(uint32_t &eal, uint32_t &eah)
+	uint8_t am_abil(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		register uint16_t	al = getByte(pbr.a | pc.w++);
-		register uint16_t	ah = getByte(pbr.a | pc.w++);
+		register uint16_t	al = fetch();
+		register uint16_t	ah = fetch();
 
 		al = (ah << 8) | al + x.w;
 		ah = al + 1;
 
 		register uint16_t	au = ah + 1;
 
-		eal = (getByte(au) << 16) | getWord(al, ah);
+		eal = getLong(al, ah, au);
 		eah = eal + 1;
-		return (4);
+		return (0);
 	}
 
 	// Absolute Long
-	static uint8_t am_alng(uint32_t &eal, uint32_t &eah)
+	uint8_t am_alng(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(3);
 
-		register uint8_t	al = getByte(pbr.a | pc.w++);
-		register uint8_t	ah = getByte(pbr.a | pc.w++);
-		register uint8_t	au = getByte(pbr.a | pc.w++);
+		register uint8_t	al = fetch();
+		register uint8_t	ah = fetch();
+		register uint8_t	au = fetch();
 
 		eal = ((au << 16) | (ah << 8) | al);
 		eah = eal + 1;
-		return (3);
+		return (0);
 	}
 
 	// Absolute Long Indexed by X
-	static uint8_t am_alnx(uint32_t &eal, uint32_t &eah)
+	uint8_t am_alnx(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(3);
 
-		register uint8_t	al = getByte(pbr.a | pc.w++);
-		register uint8_t	ah = getByte(pbr.a | pc.w++);
-		register uint8_t	au = getByte(pbr.a | pc.w++);
+		register uint8_t	al = fetch();
+		register uint8_t	ah = fetch();
+		register uint8_t	au = fetch();
 
 		eal = ((au << 16) | (ah << 8) | al) + x.w;
 		eah = eal + 1;
-		return (3);
+		return (0);
 	}
 
 	// Immediate Byte
-	static uint8_t am_immb(uint32_t &eal, uint32_t &eah)
+	uint8_t am_immb(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		eal = pbr.a | pc.w++;
+		eal = skip();
 		eah = 0;
 		return (0);
 	}
 
 	// Immediate Word (PEA only)
-	static uint8_t am_immw(uint32_t &eal, uint32_t &eah)
+	uint8_t am_immw(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		eal = pbr.a | pc.w++;
-		eah = pbr.a | pc.w++;
+		eal = skip();
+		eah = skip();
 		return (0);
 	}
 
 	// Implied
-	static uint8_t am_impl(uint32_t &eal, uint32_t &eah)
+	uint8_t am_impl(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(0);
 
@@ -407,152 +853,152 @@ protected:
 	}
 
 	// Relative
-	static uint8_t am_rela(uint32_t &eal, uint32_t &eah)
+	uint8_t am_rela(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t dl = getByte(pbr.a | pc.w++);
+		register uint8_t dl = fetch();
 
 		eal = pbr.a | ((pc.w + (int8_t)dl) & 0xffff);
 		eah = 0;
-		return (1);
+		return (0);
 	}
 
 	// Long Relative
-	static uint8_t am_lrel(uint32_t &eal, uint32_t &eah)
+	uint8_t am_lrel(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		register uint8_t dl = getByte(pbr.a | pc.w++);
-		register uint8_t dh = getByte(pbr.a | pc.w++);
+		register uint8_t dl = fetch();
+		register uint8_t dh = fetch();
 
 		eal = pbr.a | ((pc.w + (int16_t)((dh << 8) | dl)) & 0xffff);
 		eah = 0;
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_clc(uint32_t eal, uint32_t eah)
+	uint8_t op_clc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(clc);
 
 		setc(false);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_cld(uint32_t eal, uint32_t eah)
+	uint8_t op_cld(uint32_t eal, uint32_t eah)
 	{
 		TRACE(cld);
 
 		setd(false);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_cli(uint32_t eal, uint32_t eah)
+	uint8_t op_cli(uint32_t eal, uint32_t eah)
 	{
 		TRACE(cli);
 
 		seti(false);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_clv(uint32_t eal, uint32_t eah)
+	uint8_t op_clv(uint32_t eal, uint32_t eah)
 	{
 		TRACE(clv);
 
 		setv(false);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_jml(uint32_t eal, uint32_t eah)
+	uint8_t op_jml(uint32_t eal, uint32_t eah)
 	{
 		TRACE(jml);
 
 		pbr.b = eal >> 16;
 		pc.w = (uint16_t)eal;
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_jmp(uint32_t eal, uint32_t eah)
+	uint8_t op_jmp(uint32_t eal, uint32_t eah)
 	{
 		TRACE(jmp);
 
 		pc.w = (uint16_t)eal;
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_nop(uint32_t eal, uint32_t eah)
+	uint8_t op_nop(uint32_t eal, uint32_t eah)
 	{
 		TRACE(nop);
 
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_sec(uint32_t eal, uint32_t eah)
+	uint8_t op_sec(uint32_t eal, uint32_t eah)
 	{
 		TRACE(sec);
 
 		setc(true);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_sed(uint32_t eal, uint32_t eah)
+	uint8_t op_sed(uint32_t eal, uint32_t eah)
 	{
 		TRACE(sed);
 
 		setd(true);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_sei(uint32_t eal, uint32_t eah)
+	uint8_t op_sei(uint32_t eal, uint32_t eah)
 	{
 		TRACE(sei);
 
 		seti(true);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_stp(uint32_t eal, uint32_t eah)
+	uint8_t op_stp(uint32_t eal, uint32_t eah)
 	{
 		TRACE(stp);
 
 		stop();
 		--pc.w;
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tcd(uint32_t eal, uint32_t eah)
+	uint8_t op_tcd(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tcd);
 
 		dp.w = c.w;
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tcs(uint32_t eal, uint32_t eah)
+	uint8_t op_tcs(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tcs);
 
 		sp.w = c.w;
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tdc(uint32_t eal, uint32_t eah)
+	uint8_t op_tdc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tdc);
 
 		setnz_w(c.w = dp.w);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tsc(uint32_t eal, uint32_t eah)
+	uint8_t op_tsc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tsc);
 
 		setnz_w(c.w = sp.w);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_wai(uint32_t eal, uint32_t eah)
+	uint8_t op_wai(uint32_t eal, uint32_t eah)
 	{
 		TRACE(wai);
 
@@ -568,21 +1014,19 @@ protected:
 			--pc.w;
 		}
 
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_wdm(uint32_t eal, uint32_t eah);
-
-	static uint8_t op_xba(uint32_t eal, uint32_t eah)
+	uint8_t op_xba(uint32_t eal, uint32_t eah)
 	{
 		TRACE(xba);
 
 		c.w = (c.l << 8) | c.h;
 		setnz_b(c.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_xce(uint32_t eal, uint32_t eah)
+	uint8_t op_xce(uint32_t eal, uint32_t eah)
 	{
 		TRACE(xce);
 
@@ -590,8 +1034,8 @@ protected:
 
 		p.c = e;
 		e = ne;
-		Emulator::setMode();
-		return (2);
+		setMode();
+		return (0);
 	}
 };
 
@@ -599,29 +1043,162 @@ protected:
 // Emulation Mode
 //------------------------------------------------------------------------------
 
-class ModeE : public Registers
+template<class B>
+class ModeE : public Common<B>
 {
-private:
+protected:
 	ModeE() { }
 
-	static void pushByte(uint8_t b)
+	// The fixed cycles of the addressing modes and operations in this class.
+	// Conditional penalties are returned by the functions themselves.
+	enum {
+		am_absl_CY				= 2,
+		am_absp_CY				= 2,
+		am_absx_CY				= 2,
+		am_absy_CY				= 2,
+		am_abxw_CY				= 3,
+		am_abyw_CY				= 3,
+		am_dpag_CY				= 1,
+		am_dpgx_CY				= 1,
+		am_dpgy_CY				= 1,
+		am_dpgi_CY				= 3,
+		am_dpix_CY				= 3,
+		am_dpiy_CY				= 3,
+		am_dpyw_CY				= 4,
+		am_dpil_CY				= 4,
+		am_dily_CY				= 4,
+		am_immm_CY				= 0,
+		am_immx_CY				= 0,
+		am_srel_CY				= 2,
+		am_sriy_CY				= 5,
+		op_adc_CY				= 2,
+		op_and_CY				= 2,
+		op_asl_CY				= 4,
+		op_asla_CY				= 2,
+		op_bcc_CY				= 2,
+		op_bcs_CY				= 2,
+		op_beq_CY				= 2,
+		op_bit_CY				= 2,
+		op_biti_CY				= 2,
+		op_bmi_CY				= 2,
+		op_bne_CY				= 2,
+		op_bpl_CY				= 2,
+		op_bra_CY				= 3,
+		op_brl_CY				= 3,
+		op_brk_CY				= 6,
+		op_bvc_CY				= 2,
+		op_bvs_CY				= 2,
+		op_cop_CY				= 7,
+		op_cmp_CY				= 2,
+		op_cpx_CY				= 2,
+		op_cpy_CY				= 2,
+		op_dec_CY				= 4,
+		op_deca_CY				= 2,
+		op_dex_CY				= 2,
+		op_dey_CY				= 2,
+		op_eor_CY				= 2,
+		op_inc_CY				= 4,
+		op_inca_CY				= 2,
+		op_inx_CY				= 2,
+		op_iny_CY				= 2,
+		op_jsl_CY				= 2,
+		op_jsr_CY				= 4,
+		op_lda_CY				= 2,
+		op_ldx_CY				= 2,
+		op_ldy_CY				= 2,
+		op_lsr_CY				= 4,
+		op_lsra_CY				= 2,
+		op_mvn_CY				= 7,
+		op_mvp_CY				= 7,
+		op_ora_CY				= 2,
+		op_pea_CY				= 5,
+		op_pei_CY				= 5,
+		op_per_CY				= 5,
+		op_pha_CY				= 3,
+		op_phb_CY				= 3,
+		op_phd_CY				= 4,
+		op_phk_CY				= 3,
+		op_plb_CY				= 4,
+		op_pld_CY				= 5,
+		op_php_CY				= 3,
+		op_phx_CY				= 3,
+		op_phy_CY				= 3,
+		op_pla_CY				= 4,
+		op_plp_CY				= 4,
+		op_plx_CY				= 4,
+		op_ply_CY				= 4,
+		op_rep_CY				= 3,
+		op_rol_CY				= 4,
+		op_rola_CY				= 2,
+		op_ror_CY				= 4,
+		op_rora_CY				= 2,
+		op_rti_CY				= 6,
+		op_rtl_CY				= 6,
+		op_rts_CY				= 6,
+		op_sbc_CY				= 2,
+		op_sep_CY				= 3,
+		op_sta_CY				= 2,
+		op_stx_CY				= 2,
+		op_sty_CY				= 2,
+		op_stz_CY				= 2,
+		op_tax_CY				= 2,
+		op_tay_CY				= 2,
+		op_trb_CY				= 2,
+		op_tsb_CY				= 2,
+		op_tsx_CY				= 2,
+		op_txa_CY				= 2,
+		op_txs_CY				= 2,
+		op_txy_CY				= 2,
+		op_tya_CY				= 2,
+		op_tyx_CY				= 2
+	};
+
+	using Common<B>::pc;
+	using Common<B>::sp;
+	using Common<B>::dp;
+	using Common<B>::c;
+	using Common<B>::x;
+	using Common<B>::y;
+	using Common<B>::pbr;
+	using Common<B>::dbr;
+	using Common<B>::p;
+	using Common<B>::am_immw_CY;
+	using Common<B>::fetch;
+	using Common<B>::getByte;
+	using Common<B>::getLong;
+	using Common<B>::getWord;
+	using Common<B>::getn;
+	using Common<B>::getp;
+	using Common<B>::getz;
+	using Common<B>::owed;
+	using Common<B>::setByte;
+	using Common<B>::setc;
+	using Common<B>::setn;
+	using Common<B>::setnz_b;
+	using Common<B>::setnz_w;
+	using Common<B>::setp;
+	using Common<B>::setv;
+	using Common<B>::setz;
+	using Common<B>::skip;
+
+	void pushByte(uint8_t b)
 	{
 		setByte(sp.w, b);
 		--sp.l;
 	}
 
-	static uint8_t pullByte(void)
+	uint8_t pullByte(void)
 	{
 		++sp.l;
 		return (getByte(sp.w));
 	}
 
 protected:
-	static uint8_t do_irq(void)
+	uint8_t do_irq(void)
 	{
 		pushByte(pc.h);
 		pushByte(pc.l);
-		pushByte((p.f | 0x20) & 0xef);
+		pushByte((getp() | 0x20) & 0xef);
 		p.i = 1;
 		p.d = 0;
 
@@ -630,11 +1207,11 @@ protected:
 		return (7);
 	}
 
-	static uint8_t do_nmi(void)
+	uint8_t do_nmi(void)
 	{
 		pushByte(pc.h);
 		pushByte(pc.l);
-		pushByte(p.f | 0x30);
+		pushByte(getp() | 0x30);
 		p.i = 1;
 		p.d = 0;
 
@@ -643,11 +1220,11 @@ protected:
 		return (7);
 	}
 
-	static uint8_t do_abort(void)
+	uint8_t do_abort(void)
 	{
 		pushByte(pc.h);
 		pushByte(pc.l);
-		pushByte(p.f | 0x30);
+		pushByte(getp() | 0x30);
 		p.i = 1;
 		p.d = 0;
 
@@ -657,221 +1234,245 @@ protected:
 	}
 
 	// Absolute
-	static uint8_t am_absl(uint32_t &eal, uint32_t &eah)
+	uint8_t am_absl(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		register uint8_t	al = getByte(pbr.a | pc.w++);
-		register uint8_t	ah = getByte(pbr.a | pc.w++);
+		register uint8_t	al = fetch();
+		register uint8_t	ah = fetch();
 
 		eal = dbr.a | ((ah << 8) | al);
 		eah = eal + 1;
 
-		return (2);
+		return (0);
 	}
 
 	// Absolute (JMP/JSR)
-	static uint8_t am_absp(uint32_t &eal, uint32_t &eah)
+	uint8_t am_absp(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		register uint8_t	al = getByte(pbr.a | pc.w++);
-		register uint8_t	ah = getByte(pbr.a | pc.w++);
+		register uint8_t	al = fetch();
+		register uint8_t	ah = fetch();
 
 		eal = pbr.a | ((ah << 8) | al);
 		eah = eal + 1;
 
-		return (2);
+		return (0);
 	}
 
 	// Absolute Indexed X
-	static uint8_t am_absx(uint32_t &eal, uint32_t &eah)
+	uint8_t am_absx(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		register uint8_t	al = getByte(pbr.a | pc.w++);
-		register uint8_t	ah = getByte(pbr.a | pc.w++);
+		register uint8_t	al = fetch();
+		register uint8_t	ah = fetch();
 
 		eal = (dbr.a | ((ah << 8) | al)) + x.w;
 		eah = eal + 1;
 
-		return (2);
+		return ((al + x.l > 0xff) ? 1 : 0);
 	}
 
 	// Absolute Indexed Y
-	static uint8_t am_absy(uint32_t &eal, uint32_t &eah)
+	uint8_t am_absy(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		register uint8_t	al = getByte(pbr.a | pc.w++);
-		register uint8_t	ah = getByte(pbr.a | pc.w++);
+		register uint8_t	al = fetch();
+		register uint8_t	ah = fetch();
 
 		eal = (dbr.a | ((ah << 8) | al)) + y.w;
 		eah = eal + 1;
 
-		return (2);
+		return ((al + y.l > 0xff) ? 1 : 0);
+	}
+
+	// Absolute Indexed X and Y for stores and read-modify-writes, which
+	// always take the indexing cycle whether or not a page is crossed
+	uint8_t am_abxw(uint32_t &eal, uint32_t &eah)
+	{
+		am_absx(eal, eah);
+		return (0);
+	}
+
+	uint8_t am_abyw(uint32_t &eal, uint32_t &eah)
+	{
+		am_absy(eal, eah);
+		return (0);
 	}
 
 	// Direct Page
-	static uint8_t am_dpag(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dpag(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 
 		eal = dp.w + ((of + 0) & 0xff);
 		eah = dp.w + ((of + 1) & 0xff);
 
-		return ((dp.l) ? 2 : 1);
+		return ((dp.l) ? 1 : 0);
 	}
 
 	// Direct Page Indexed X
-	static uint8_t am_dpgx(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dpgx(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 
 		eal = (dp.w + ((of + x.l + 0) & 0xff)) & 0xffff;
 		eah = (dp.w + ((of + x.l + 1) & 0xff)) & 0xffff;
 
-		return ((dp.l) ? 2 : 1);
+		return ((dp.l) ? 1 : 0);
 	}
 
 	// Direct Page Indexed Y
-	static uint8_t am_dpgy(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dpgy(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 
 		eal = (dp.w + ((of + y.l + 0) & 0xff)) & 0xffff;
 		eah = (dp.w + ((of + y.l + 1) & 0xff)) & 0xffff;
 
-		return ((dp.l) ? 2 : 1);
+		return ((dp.l) ? 1 : 0);
 	}
 
 	// Direct Page Indirect
-	static uint8_t am_dpgi(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dpgi(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 
 		register uint16_t	al = (dp.w + ((of + 0) & 0xff));
 		register uint16_t   ah = (dp.w + ((of + 1) & 0xff));
 
 		eal = dbr.a | getWord(al, ah);
 		eah = eal + 1;		
-		return ((dp.l) ? 4 : 3);
+		return ((dp.l) ? 1 : 0);
 	}
 
-	static uint8_t am_dpix(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dpix(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 
 		register uint16_t	al = (dp.w + ((of + x.l + 0) & 0xff));
 		register uint16_t   ah = (dp.w + ((of + x.l + 1) & 0xff));
 
 		eal = dbr.a | getWord(al, ah);
 		eah = eal + 1;
-		return ((dp.l) ? 4 : 3);
+		return ((dp.l) ? 1 : 0);
 	}
 
-	static uint8_t am_dpiy(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dpiy(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 
 		register uint16_t	al = (dp.w + ((of + 0) & 0xff));
 		register uint16_t   ah = (dp.w + ((of + 1) & 0xff));
 
-		eal = (dbr.a | getWord(al, ah)) + y.l;
+		register uint16_t	ad = getWord(al, ah);
+
+		eal = (dbr.a | ad) + y.l;
 		eah = eal + 1;
-		return ((dp.l) ? 4 : 3);
+		return (((dp.l) ? 1 : 0) + (((ad & 0xff) + y.l > 0xff) ? 1 : 0));
 	}
 
-	static uint8_t am_dpil(uint32_t &eal, uint32_t &eah)
+	// Direct Page Indirect Indexed Y for stores, which always take the
+	// indexing cycle
+	uint8_t am_dpyw(uint32_t &eal, uint32_t &eah)
+	{
+		am_dpiy(eal, eah);
+		return ((dp.l) ? 1 : 0);
+	}
+
+	uint8_t am_dpil(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 		register uint16_t	al = (dp.w + ((of + 0) & 0xff));
 		register uint16_t   ah = (dp.w + ((of + 1) & 0xff));
 		register uint16_t   au = (dp.w + ((of + 2) & 0xff));
 
-		eal = ((getByte (au) << 16) | getWord (al, ah));
+		eal = getLong(al, ah, au);
 		eah = eal + 1;
-		return (4);
+		return ((dp.l) ? 1 : 0);
 	}
 
-	static uint8_t am_dily(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dily(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 		register uint16_t	al = (dp.w + ((of + 0) & 0xff));
 		register uint16_t   ah = (dp.w + ((of + 1) & 0xff));
 		register uint16_t   au = (dp.w + ((of + 2) & 0xff));
 
-		eal = ((getByte (au) << 16) | getWord (al, ah)) + y.l;
+		eal = getLong(al, ah, au) + y.l;
 		eah = eal + 1;
-		return (4);
+		return ((dp.l) ? 1 : 0);
 	}
 
 	// Immediate (based on M)
-	static uint8_t am_immm(uint32_t &eal, uint32_t &eah)
+	uint8_t am_immm(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		eal = pbr.a | pc.w++;
+		eal = skip();
 		eah = 0;
 		return (0);
 	}
 
 	// Immediate (based on X)
-	static uint8_t am_immx(uint32_t &eal, uint32_t &eah)
+	uint8_t am_immx(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		eal = pbr.a | pc.w++;
+		eal = skip();
 		eah = 0;
 		return (0);
 	}
 
 	// Stack Relative
-	static uint8_t am_srel(uint32_t &eal, uint32_t &eah)
+	uint8_t am_srel(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
 		register Word		ad = sp;
 
-		ad.l += getByte(pbr.a | pc.w++);
+		ad.l += fetch();
 		eal = ad.w;
 		eah = 0;
-		return (2);
+		return (0);
 	}
 
-	static uint8_t am_sriy(uint32_t &eal, uint32_t &eah)
+	uint8_t am_sriy(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
 		register Word		ad = sp;
 
-		ad.l += getByte(pbr.a | pc.w++);
+		ad.l += fetch();
 
 		register uint8_t	al = getByte(ad.w++);
 		register uint8_t	ah = getByte(ad.w++);
 		
 		eal = (dbr.a | (ah << 8) | al) + y.l;
 		eah = eal + 1;
-		return (5);
+		return (0);
 	}
 
-	static uint8_t op_adc(uint32_t eal, uint32_t eah)
+	uint8_t op_adc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(adc);
 
@@ -886,18 +1487,18 @@ protected:
 		setc(temp & 0x100);
 		setv((~(c.l ^ data)) & (c.l ^ temp) & 0x80);
 		setnz_b(c.l = (uint8_t)temp);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_and(uint32_t eal, uint32_t eah)
+	uint8_t op_and(uint32_t eal, uint32_t eah)
 	{
 		TRACE(and);
 
 		setnz_b(c.l &= Memory::getByte(eal));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_asl(uint32_t eal, uint32_t eah)
+	uint8_t op_asl(uint32_t eal, uint32_t eah)
 	{
 		TRACE(asl);
 
@@ -906,19 +1507,19 @@ protected:
 		setc(data & 0x80);
 		setnz_b(data <<= 1);
 		Memory::setByte(eal, data);
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_asla(uint32_t eal, uint32_t eah)
+	uint8_t op_asla(uint32_t eal, uint32_t eah)
 	{
 		TRACE(asl);
 
 		setc(c.l & 0x80);
 		setnz_b(c.l <<= 1);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bcc(uint32_t eal, uint32_t eah)
+	uint8_t op_bcc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bcc);
 
@@ -926,12 +1527,12 @@ protected:
 
 		if (p.c == 0) {
 			pc.w = eal;
-			return (samePage ? 3 : 4);
+			return (samePage ? 1 : 2);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bcs(uint32_t eal, uint32_t eah)
+	uint8_t op_bcs(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bcs);
 
@@ -939,25 +1540,25 @@ protected:
 
 		if (p.c == 1) {
 			pc.w = eal;
-			return (samePage ? 3 : 4);
+			return (samePage ? 1 : 2);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_beq(uint32_t eal, uint32_t eah)
+	uint8_t op_beq(uint32_t eal, uint32_t eah)
 	{
 		TRACE(beq);
 
 		register bool samePage = ((pc.w ^ eal) & 0xff00) == 0x0000;
 
-		if (p.z == 1) {
+		if (getz()) {
 			pc.w = eal;
-			return (samePage ? 3 : 4);
+			return (samePage ? 1 : 2);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bit(uint32_t eal, uint32_t eah)
+	uint8_t op_bit(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bit);
 
@@ -966,92 +1567,92 @@ protected:
 		setn(data & 0x80);
 		setv(data & 0x40);
 		setz((data & c.l) == 0x00);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_biti(uint32_t eal, uint32_t eah)
+	uint8_t op_biti(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bit);
 
 		register uint8_t data = getByte(eal);
 
 		setz((data & c.l) == 0x00);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bmi(uint32_t eal, uint32_t eah)
+	uint8_t op_bmi(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bmi);
 
 		register bool samePage = ((pc.w ^ eal) & 0xff00) == 0x0000;
 
-		if (p.n == 1) {
+		if (getn()) {
 			pc.w = eal;
-			return (samePage ? 3 : 4);
+			return (samePage ? 1 : 2);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bne(uint32_t eal, uint32_t eah)
+	uint8_t op_bne(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bne);
 
 		register bool samePage = ((pc.w ^ eal) & 0xff00) == 0x0000;
 
-		if (p.z == 0) {
+		if (!getz()) {
 			pc.w = eal;
-			return (samePage ? 3 : 4);
+			return (samePage ? 1 : 2);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bpl(uint32_t eal, uint32_t eah)
+	uint8_t op_bpl(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bpl);
 
 		register bool samePage = ((pc.w ^ eal) & 0xff00) == 0x0000;
 
-		if (p.n == 0) {
+		if (!getn()) {
 			pc.w = eal;
-			return (samePage ? 3 : 4);
+			return (samePage ? 1 : 2);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bra(uint32_t eal, uint32_t eah)
+	uint8_t op_bra(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bra);
 
 		register bool samePage = ((pc.w ^ eal) & 0xff00) == 0x0000;
 
 		pc.w = eal;
-		return (samePage ? 3 : 4);
+		return (samePage ? 0 : 1);
 	}
 
-	static uint8_t op_brl(uint32_t eal, uint32_t eah)
+	uint8_t op_brl(uint32_t eal, uint32_t eah)
 	{
 		TRACE(brl);
 
 		pc.w = eal;
-		return (3);
+		return (0);
 	}
 
-	static uint8_t op_brk(uint32_t eal, uint32_t eah)
+	uint8_t op_brk(uint32_t eal, uint32_t eah)
 	{
 		TRACE(brk);
 
 		pushByte(pc.h);
 		pushByte(pc.l);
-		pushByte(p.f | 0x30);
+		pushByte(getp() | 0x30);
 		p.i = 1;
 		p.d = 0;
 
 		pc.w = getWord(0xfffe, 0xffff);
 		pbr.b = 0;
-		return (6);
+		return (0);
 	}
 
-	static uint8_t op_bvc(uint32_t eal, uint32_t eah)
+	uint8_t op_bvc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bvc);
 
@@ -1059,12 +1660,12 @@ protected:
 
 		if (p.v == 0) {
 			pc.w = eal;
-			return (samePage ? 3 : 4);
+			return (samePage ? 1 : 2);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bvs(uint32_t eal, uint32_t eah)
+	uint8_t op_bvs(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bvs);
 
@@ -1072,27 +1673,27 @@ protected:
 
 		if (p.v == 1) {
 			pc.w = eal;
-			return (samePage ? 3 : 4);
+			return (samePage ? 1 : 2);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_cop(uint32_t eal, uint32_t eah)
+	uint8_t op_cop(uint32_t eal, uint32_t eah)
 	{
 		TRACE(cop);
 
 		pushByte(pc.h);
 		pushByte(pc.l);
-		pushByte(p.f | 0x30);
+		pushByte(getp() | 0x30);
 		p.i = 1;
 		p.d = 0;
 
 		pc.w = getWord(0xfff4, 0xfff5);
 		pbr.b = 0;
-		return (7);
+		return (0);
 	}
 
-	static uint8_t op_cmp(uint32_t eal, uint32_t eah)
+	uint8_t op_cmp(uint32_t eal, uint32_t eah)
 	{
 		TRACE(cmp);
 
@@ -1101,10 +1702,10 @@ protected:
 
 		setnz_b((uint8_t)diff);
 		setc(!(diff & 0x100));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_cpx(uint32_t eal, uint32_t eah)
+	uint8_t op_cpx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(cpx);
 
@@ -1113,10 +1714,10 @@ protected:
 
 		setnz_b((uint8_t)diff);
 		setc(!(diff & 0x100));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_cpy(uint32_t eal, uint32_t eah)
+	uint8_t op_cpy(uint32_t eal, uint32_t eah)
 	{
 		TRACE(cpy);
 
@@ -1125,10 +1726,10 @@ protected:
 
 		setnz_b((uint8_t)diff);
 		setc(!(diff & 0x100));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_dec(uint32_t eal, uint32_t eah)
+	uint8_t op_dec(uint32_t eal, uint32_t eah)
 	{
 		TRACE(dec);
 
@@ -1136,42 +1737,42 @@ protected:
 
 		setByte(eal, --data);
 		setnz_b(data);
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_deca(uint32_t eal, uint32_t eah)
+	uint8_t op_deca(uint32_t eal, uint32_t eah)
 	{
 		TRACE(dec);
 
 		setnz_b(--c.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_dex(uint32_t eal, uint32_t eah)
+	uint8_t op_dex(uint32_t eal, uint32_t eah)
 	{
 		TRACE(dex);
 
 		setnz_b(--x.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_dey(uint32_t eal, uint32_t eah)
+	uint8_t op_dey(uint32_t eal, uint32_t eah)
 	{
 		TRACE(dey);
 
 		setnz_b(--y.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_eor(uint32_t eal, uint32_t eah)
+	uint8_t op_eor(uint32_t eal, uint32_t eah)
 	{
 		TRACE(eor);
 
 		setnz_b(c.l ^= getByte(eal));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_inc(uint32_t eal, uint32_t eah)
+	uint8_t op_inc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(inc);
 
@@ -1179,34 +1780,34 @@ protected:
 
 		setByte(eal, ++data);
 		setnz_b(data);
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_inca(uint32_t eal, uint32_t eah)
+	uint8_t op_inca(uint32_t eal, uint32_t eah)
 	{
 		TRACE(inc);
 
 		setnz_b(++c.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_inx(uint32_t eal, uint32_t eah)
+	uint8_t op_inx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(inx);
 
 		setnz_b(++x.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_iny(uint32_t eal, uint32_t eah)
+	uint8_t op_iny(uint32_t eal, uint32_t eah)
 	{
 		TRACE(iny);
 
 		setnz_b(++y.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_jsl(uint32_t eal, uint32_t eah)
+	uint8_t op_jsl(uint32_t eal, uint32_t eah)
 	{
 		TRACE(jsl);
 
@@ -1217,10 +1818,10 @@ protected:
 
 		pbr.b = eal >> 16;
 		pc.w = (uint16_t)eal;
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_jsr(uint32_t eal, uint32_t eah)
+	uint8_t op_jsr(uint32_t eal, uint32_t eah)
 	{
 		TRACE(jsr);
 
@@ -1229,34 +1830,34 @@ protected:
 		pushByte(pc.l);
 
 		pc.w = (uint16_t)eal;
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_lda(uint32_t eal, uint32_t eah)
+	uint8_t op_lda(uint32_t eal, uint32_t eah)
 	{
 		TRACE(lda);
 
 		setnz_b(c.l = getByte(eal));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_ldx(uint32_t eal, uint32_t eah)
+	uint8_t op_ldx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ldx);
 
 		setnz_b(x.l = getByte(eal));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_ldy(uint32_t eal, uint32_t eah)
+	uint8_t op_ldy(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ldy);
 
 		setnz_b(y.l = getByte(eal));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_lsr(uint32_t eal, uint32_t eah)
+	uint8_t op_lsr(uint32_t eal, uint32_t eah)
 	{
 		TRACE(lsr);
 
@@ -1265,195 +1866,218 @@ protected:
 		setc(data & 0x01);
 		setnz_b(data >>= 1);
 		setByte(eal, data);
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_lsra(uint32_t eal, uint32_t eah)
+	uint8_t op_lsra(uint32_t eal, uint32_t eah)
 	{
 		TRACE(lsr);
 
 		setc(c.l & 0x01);
 		setnz_b(c.l >>= 1);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_mvn(uint32_t eal, uint32_t eah)
+	// The block moves run as many bytes as they can in one dispatch, up to
+	// the end of the count, an index wrapping or MOVE_BYTES, and owe the
+	// cycles of the repeats they saved. The instruction is repeated until the
+	// count is exhausted.
+	uint8_t op_mvn(uint32_t eal, uint32_t eah)
 	{
 		TRACE(mvn);
 
 		register uint32_t	dst = getByte(eal) << 16;
 		register uint32_t	src = getByte(eah) << 16;
-
-		setByte(dbr.a = dst | y.l++, getByte(src | x.l++));
-		if (c.l-- != 0x00) pc.w -= 3;
-		return (7);
+		register uint32_t	size = c.l + 1;
+
+		if (size > 0x100u - x.l) size = 0x100 - x.l;
+		if (size > 0x100u - y.l) size = 0x100 - y.l;
+		if (size > MOVE_BYTES) size = MOVE_BYTES;
+
+		Memory::copy(dst | y.l, src | x.l, size, true);
+		dbr.a = dst;
+		x.l += size;
+		y.l += size;
+		owed += (size - 1) * (am_immw_CY + op_mvn_CY);
+		if ((c.l -= size) != 0xff) pc.w -= 3;
+		return (0);
 	}
 
-	static uint8_t op_mvp(uint32_t eal, uint32_t eah)
+	uint8_t op_mvp(uint32_t eal, uint32_t eah)
 	{
 		TRACE(mvp);
 
 		register uint32_t	dst = getByte(eal) << 16;
 		register uint32_t	src = getByte(eah) << 16;
-
-		setByte(dbr.a = dst | y.l--, getByte(src | x.l--));
-		if (c.l-- != 0x00) pc.w -= 3;
-		return (7);
+		register uint32_t	size = c.l + 1;
+
+		if (size > x.l + 1u) size = x.l + 1;
+		if (size > y.l + 1u) size = y.l + 1;
+		if (size > MOVE_BYTES) size = MOVE_BYTES;
+
+		Memory::copy(dst | (y.l + 1 - size), src | (x.l + 1 - size), size, false);
+		dbr.a = dst;
+		x.l -= size;
+		y.l -= size;
+		owed += (size - 1) * (am_immw_CY + op_mvp_CY);
+		if ((c.l -= size) != 0xff) pc.w -= 3;
+		return (0);
 	}
 
-	static uint8_t op_ora(uint32_t eal, uint32_t eah)
+	uint8_t op_ora(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ora);
 
 		setnz_b(c.l |= getByte(eal));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_pea(uint32_t eal, uint32_t eah)
+	uint8_t op_pea(uint32_t eal, uint32_t eah)
 	{
 		TRACE(pea);
 
 		pushByte(getByte(eah));
 		pushByte(getByte(eal));
-		return (5);
+		return (0);
 	}
 
-	static uint8_t op_pei(uint32_t eal, uint32_t eah)
+	uint8_t op_pei(uint32_t eal, uint32_t eah)
 	{
 		TRACE(pei);
 
 		pushByte(getByte(eah));
 		pushByte(getByte(eal));
-		return (5);
+		return (0);
 	}
 
-	static uint8_t op_per(uint32_t eal, uint32_t eah)
+	uint8_t op_per(uint32_t eal, uint32_t eah)
 	{
 		TRACE(pel);
 
 		pushByte(eal >> 8);
 		pushByte(eal >> 0);
-		return (5);
+		return (0);
 	}
 
-	static uint8_t op_pha(uint32_t eal, uint32_t eah)
+	uint8_t op_pha(uint32_t eal, uint32_t eah)
 	{
 		TRACE(pha);
 
 		pushByte(c.l);
-		return (3);
+		return (0);
 	}
 
-	static uint8_t op_phb(uint32_t eal, uint32_t eah)
+	uint8_t op_phb(uint32_t eal, uint32_t eah)
 	{
 		TRACE(phb);
 
 		pushByte(dbr.b);
-		return (3);
+		return (0);
 	}
 
-	static uint8_t op_phd(uint32_t eal, uint32_t eah)
+	uint8_t op_phd(uint32_t eal, uint32_t eah)
 	{
 		TRACE(phd);
 
 		pushByte(dp.h);
 		pushByte(dp.l);
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_phk(uint32_t eal, uint32_t eah)
+	uint8_t op_phk(uint32_t eal, uint32_t eah)
 	{
 		TRACE(phk);
 
 		pushByte(pbr.b);
-		return (3);
+		return (0);
 	}
 
-	static uint8_t op_plb(uint32_t eal, uint32_t eah)
+	uint8_t op_plb(uint32_t eal, uint32_t eah)
 	{
 		TRACE(plb);
 
 		dbr.b = pullByte();
 		setnz_b(dbr.b);
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_pld(uint32_t eal, uint32_t eah)
+	uint8_t op_pld(uint32_t eal, uint32_t eah)
 	{
 		TRACE(pld);
 
 		dp.l = pullByte();
 		dp.h = pullByte();
 		setnz_w(dp.w);
-		return (5);
+		return (0);
 	}
 
-	static uint8_t op_php(uint32_t eal, uint32_t eah)
+	uint8_t op_php(uint32_t eal, uint32_t eah)
 	{
 		TRACE(php);
 
-		pushByte(p.f | 0x30);
-		return (3);
+		pushByte(getp() | 0x30);
+		return (0);
 	}
 
-	static uint8_t op_phx(uint32_t eal, uint32_t eah)
+	uint8_t op_phx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(phx);
 
 		pushByte(x.l);
-		return (3);
+		return (0);
 	}
 
-	static uint8_t op_phy(uint32_t eal, uint32_t eah)
+	uint8_t op_phy(uint32_t eal, uint32_t eah)
 	{
 		TRACE(phy);
 
 		pushByte(y.l);
-		return (3);
+		return (0);
 	}
 
-	static uint8_t op_pla(uint32_t eal, uint32_t eah)
+	uint8_t op_pla(uint32_t eal, uint32_t eah)
 	{
 		TRACE(pla);
 
 		setnz_b(c.l = pullByte());
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_plp(uint32_t eal, uint32_t eah)
+	uint8_t op_plp(uint32_t eal, uint32_t eah)
 	{
 		TRACE(plp);
 
-		setnz_b(p.f = pullByte() | 0x30);
-		return (4);
+		setp(pullByte() | 0x30);
+		setnz_b(p.f);
+		return (0);
 	}
 
-	static uint8_t op_plx(uint32_t eal, uint32_t eah)
+	uint8_t op_plx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(plx);
 
 		setnz_b(x.l = pullByte());
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_ply(uint32_t eal, uint32_t eah)
+	uint8_t op_ply(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ply);
 
 		setnz_b(y.l = pullByte());
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_rep(uint32_t eal, uint32_t eah)
+	uint8_t op_rep(uint32_t eal, uint32_t eah)
 	{
 		TRACE(rep);
 
-		p.f &= ~getByte(eal);
+		setp(getp() & ~getByte(eal));
 		p.m = p.x = 1;
-		return (3);
+		return (0);
 	}
 
-	static uint8_t op_rol(uint32_t eal, uint32_t eah)
+	uint8_t op_rol(uint32_t eal, uint32_t eah)
 	{
 		TRACE(rol);
 
@@ -1464,10 +2088,10 @@ protected:
 		data = (data << 1) | cin;
 		setByte(eal, data);
 		setnz_b(data);
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_rola(uint32_t eal, uint32_t eah)
+	uint8_t op_rola(uint32_t eal, uint32_t eah)
 	{
 		TRACE(rol);
 
@@ -1476,10 +2100,10 @@ protected:
 		setc(c.l & 0x80);
 		c.l = (c.l << 1) | cin;
 		setnz_b(c.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_ror(uint32_t eal, uint32_t eah)
+	uint8_t op_ror(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ror);
 
@@ -1490,10 +2114,10 @@ protected:
 		data = (data >> 1) | cin;
 		setByte(eal, data);
 		setnz_b(data);
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_rora(uint32_t eal, uint32_t eah)
+	uint8_t op_rora(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ror);
 
@@ -1502,21 +2126,21 @@ protected:
 		setc(c.l & 0x01);
 		c.l = (c.l >> 1) | cin;
 		setnz_b(c.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_rti(uint32_t eal, uint32_t eah)
+	uint8_t op_rti(uint32_t eal, uint32_t eah)
 	{
 		TRACE(rti);
 
-		p.f = pullByte() | 0x30;
+		setp(pullByte() | 0x30);
 		p.i = 0;
 		pc.l = pullByte();
 		pc.h = pullByte();
-		return (6);
+		return (0);
 	}
 
-	static uint8_t op_rtl(uint32_t eal, uint32_t eah)
+	uint8_t op_rtl(uint32_t eal, uint32_t eah)
 	{
 		TRACE(rtl);
 
@@ -1524,20 +2148,20 @@ protected:
 		pc.h = pullByte();
 		pbr.b = pullByte();
 		++pc.w;
-		return (6);
+		return (0);
 	}
 
-	static uint8_t op_rts(uint32_t eal, uint32_t eah)
+	uint8_t op_rts(uint32_t eal, uint32_t eah)
 	{
 		TRACE(rts);
 
 		pc.l = pullByte();
 		pc.h = pullByte();
 		++pc.w;
-		return (6);
+		return (0);
 	}
 
-	static uint8_t op_sbc(uint32_t eal, uint32_t eah)
+	uint8_t op_sbc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(sbc);
 
@@ -1552,66 +2176,66 @@ protected:
 		setc(temp & 0x100);
 		setv((~(c.l ^ data)) & (c.l ^ temp) & 0x80);
 		setnz_b(c.l = (uint8_t)temp);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_sep(uint32_t eal, uint32_t eah)
+	uint8_t op_sep(uint32_t eal, uint32_t eah)
 	{
 		TRACE(sep);
 
-		p.f |= getByte(eal);
-		return (3);
+		setp(getp() | getByte(eal));
+		return (0);
 	}
 
-	static uint8_t op_sta(uint32_t eal, uint32_t eah)
+	uint8_t op_sta(uint32_t eal, uint32_t eah)
 	{
 		TRACE(sta);
 
 		setByte(eal, c.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_stx(uint32_t eal, uint32_t eah)
+	uint8_t op_stx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(stx);
 
 		setByte(eal, x.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_sty(uint32_t eal, uint32_t eah)
+	uint8_t op_sty(uint32_t eal, uint32_t eah)
 	{
 		TRACE(sty);
 
 		setByte(eal, y.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_stz(uint32_t eal, uint32_t eah)
+	uint8_t op_stz(uint32_t eal, uint32_t eah)
 	{
 		TRACE(stz);
 
 		setByte(eal, 0x00);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tax(uint32_t eal, uint32_t eah)
+	uint8_t op_tax(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tax);
 
 		setnz_b(x.l = c.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tay(uint32_t eal, uint32_t eah)
+	uint8_t op_tay(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tay);
 
 		setnz_b(y.l = c.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_trb(uint32_t eal, uint32_t eah)
+	uint8_t op_trb(uint32_t eal, uint32_t eah)
 	{
 		TRACE(trb);
 
@@ -1619,10 +2243,10 @@ protected:
 
 		setz((data & c.l) == 0x00);
 		setByte(eal, data & ~c.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tsb(uint32_t eal, uint32_t eah)
+	uint8_t op_tsb(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tsb);
 
@@ -1630,55 +2254,55 @@ protected:
 
 		setz(data & c.l);
 		setByte(eal, data | c.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tsx(uint32_t eal, uint32_t eah)
+	uint8_t op_tsx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tsx);
 
 		setnz_b(x.l = sp.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_txa(uint32_t eal, uint32_t eah)
+	uint8_t op_txa(uint32_t eal, uint32_t eah)
 	{
 		TRACE(txa);
 
 		setnz_b(c.l = x.l);
-		return (2);
+		return (0);
 	}
 
-	 static uint8_t op_txs(uint32_t eal, uint32_t eah)
+	uint8_t op_txs(uint32_t eal, uint32_t eah)
 	{
 		TRACE(txs);
 
 		sp.l = x.l;
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_txy(uint32_t eal, uint32_t eah)
+	uint8_t op_txy(uint32_t eal, uint32_t eah)
 	{
 		TRACE(txy);
 
 		y.l = x.l;
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tya(uint32_t eal, uint32_t eah)
+	uint8_t op_tya(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tya);
 
 		setnz_b(c.l = y.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tyx(uint32_t eal, uint32_t eah)
+	uint8_t op_tyx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tyx);
 
 		setnz_b(x.l = y.l);
-		return (2);
+		return (0);
 	}
 };
 
@@ -1686,34 +2310,108 @@ protected:
 // Native Mode
 //------------------------------------------------------------------------------
 
-class ModeN : public Registers
+template<class B>
+class ModeN : public Common<B>
 {
-	friend class ModeM0;
-	friend class ModeM1;
-	friend class ModeX0;
-	friend class ModeX1;
-private:
+protected:
 	ModeN(void) { }
 
-	static void pushByte(uint8_t b)
+	// The fixed cycles of the addressing modes and operations in this class.
+	// Conditional penalties are returned by the functions themselves.
+	enum {
+		am_absl_CY				= 2,
+		am_absp_CY				= 2,
+		am_absx_CY				= 2,
+		am_absy_CY				= 2,
+		am_abxw_CY				= 3,
+		am_abyw_CY				= 3,
+		am_dpag_CY				= 1,
+		am_dpgx_CY				= 1,
+		am_dpgy_CY				= 1,
+		am_dpgi_CY				= 3,
+		am_dpix_CY				= 3,
+		am_dpiy_CY				= 3,
+		am_dpyw_CY				= 4,
+		am_dpil_CY				= 4,
+		am_dily_CY				= 4,
+		am_srel_CY				= 2,
+		am_sriy_CY				= 5,
+		op_bcc_CY				= 2,
+		op_bcs_CY				= 2,
+		op_beq_CY				= 2,
+		op_bmi_CY				= 2,
+		op_bne_CY				= 2,
+		op_bpl_CY				= 2,
+		op_bra_CY				= 3,
+		op_brl_CY				= 4,
+		op_brk_CY				= 8,
+		op_bvc_CY				= 2,
+		op_bvs_CY				= 2,
+		op_cop_CY				= 8,
+		op_jsl_CY				= 5,
+		op_jsr_CY				= 4,
+		op_mvn_CY				= 7,
+		op_mvp_CY				= 7,
+		op_pea_CY				= 2,
+		op_pei_CY				= 5,
+		op_per_CY				= 5,
+		op_phb_CY				= 3,
+		op_phd_CY				= 4,
+		op_phk_CY				= 3,
+		op_php_CY				= 3,
+		op_plb_CY				= 4,
+		op_pld_CY				= 5,
+		op_plp_CY				= 4,
+		op_rep_CY				= 3,
+		op_rts_CY				= 6,
+		op_rti_CY				= 7,
+		op_rtl_CY				= 6,
+		op_sep_CY				= 3
+	};
+
+	using Common<B>::pc;
+	using Common<B>::sp;
+	using Common<B>::dp;
+	using Common<B>::c;
+	using Common<B>::x;
+	using Common<B>::y;
+	using Common<B>::pbr;
+	using Common<B>::dbr;
+	using Common<B>::p;
+	using Common<B>::am_immw_CY;
+	using Common<B>::fetch;
+	using Common<B>::getByte;
+	using Common<B>::getLong;
+	using Common<B>::getWord;
+	using Common<B>::getn;
+	using Common<B>::getp;
+	using Common<B>::getz;
+	using Common<B>::owed;
+	using Common<B>::setByte;
+	using Common<B>::setMode;
+	using Common<B>::setnz_b;
+	using Common<B>::setnz_w;
+	using Common<B>::setp;
+
+	void pushByte(uint8_t b)
 	{
 		setByte(sp.w, b);
 		--sp.w;
 	}
 
-	static uint8_t pullByte(void)
+	uint8_t pullByte(void)
 	{
 		++sp.w;
 		return (getByte(sp.w));
 	}
 
 protected:
-	static uint8_t do_irq(void)
+	uint8_t do_irq(void)
 	{
 		pushByte(pbr.b);
 		pushByte(pc.h);
 		pushByte(pc.l);
-		pushByte(p.f);
+		pushByte(getp());
 		p.i = 1;
 		p.d = 0;
 
@@ -1722,12 +2420,12 @@ protected:
 		return (8);
 	}
 
-	static uint8_t do_nmi(void)
+	uint8_t do_nmi(void)
 	{
 		pushByte(pbr.b);
 		pushByte(pc.h);
 		pushByte(pc.l);
-		pushByte(p.f);
+		pushByte(getp());
 		p.i = 1;
 		p.d = 0;
 
@@ -1736,12 +2434,12 @@ protected:
 		return (8);
 	}
 
-	static uint8_t do_abort(void)
+	uint8_t do_abort(void)
 	{
 		pushByte(pbr.b);
 		pushByte(pc.h);
 		pushByte(pc.l);
-		pushByte(p.f);
+		pushByte(getp());
 		p.i = 1;
 		p.d = 0;
 
@@ -1751,335 +2449,359 @@ protected:
 	}
 
 	// Absolute
-	static uint8_t am_absl(uint32_t &eal, uint32_t &eah)
+	uint8_t am_absl(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		register uint8_t	al = getByte(pbr.a | pc.w++);
-		register uint8_t	ah = getByte(pbr.a | pc.w++);
+		register uint8_t	al = fetch();
+		register uint8_t	ah = fetch();
 
 		eal = dbr.a | ((ah << 8) | al);
 		eah = eal + 1;
 
-		return (2);
+		return (0);
 	}
 
 	// Absolute (JMP/JSR)
-	static uint8_t am_absp(uint32_t &eal, uint32_t &eah)
+	uint8_t am_absp(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		register uint8_t	al = getByte(pbr.a | pc.w++);
-		register uint8_t	ah = getByte(pbr.a | pc.w++);
+		register uint8_t	al = fetch();
+		register uint8_t	ah = fetch();
 
 		eal = pbr.a | ((ah << 8) | al);
 		eah = eal + 1;
 
-		return (2);
+		return (0);
 	}
 
 	// Absolute Indexed X
-	static uint8_t am_absx(uint32_t &eal, uint32_t &eah)
+	uint8_t am_absx(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		register uint8_t	al = getByte(pbr.a | pc.w++);
-		register uint8_t	ah = getByte(pbr.a | pc.w++);
+		register uint8_t	al = fetch();
+		register uint8_t	ah = fetch();
 
 		eal = (dbr.a | ((ah << 8) | al)) + x.w;
 		eah = eal + 1;
 
-		return (2);
+		return ((!p.x || (al + x.w > 0xff)) ? 1 : 0);
 	}
 
 	// Absolute Indexed Y
-	static uint8_t am_absy(uint32_t &eal, uint32_t &eah)
+	uint8_t am_absy(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		register uint8_t	al = getByte(pbr.a | pc.w++);
-		register uint8_t	ah = getByte(pbr.a | pc.w++);
+		register uint8_t	al = fetch();
+		register uint8_t	ah = fetch();
 
 		eal = (dbr.a | ((ah << 8) | al)) + y.w;
 		eah = eal + 1;
 
-		return (2);
+		return ((!p.x || (al + y.w > 0xff)) ? 1 : 0);
+	}
+
+	// Absolute Indexed X and Y for stores and read-modify-writes, which
+	// always take the indexing cycle whether or not a page is crossed
+	uint8_t am_abxw(uint32_t &eal, uint32_t &eah)
+	{
+		am_absx(eal, eah);
+		return (0);
+	}
+
+	uint8_t am_abyw(uint32_t &eal, uint32_t &eah)
+	{
+		am_absy(eal, eah);
+		return (0);
 	}
 
 	// Direct Page
-	static uint8_t am_dpag(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dpag(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 
 		eal = (dp.w + of + 0) & 0xffff;
 		eah = (dp.w + of + 1) & 0xffff;
 
-		return ((dp.l) ? 2 : 1);
+		return ((dp.l) ? 1 : 0);
 	}
 
 	// Direct Page Indexed X
-	static uint8_t am_dpgx(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dpgx(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 
 		eal = (dp.w + of + x.w + 0) & 0xffff;
 		eah = (dp.w + of + x.w + 1) & 0xffff;
 
-		return ((dp.l) ? 2 : 1);
+		return ((dp.l) ? 1 : 0);
 	}
 
 	// Direct Page Indexed Y
-	static uint8_t am_dpgy(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dpgy(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 
 		eal = (dp.w + of + y.w + 0) & 0xffff;
 		eah = (dp.w + of + y.w + 1) & 0xffff;
 
-		return ((dp.l) ? 2 : 1);
+		return ((dp.l) ? 1 : 0);
 	}
 
-	static uint8_t am_dpgi(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dpgi(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 
 		register uint16_t	al = (dp.w + (of + 0));
 		register uint16_t   ah = (dp.w + (of + 1));
 
 		eal = dbr.a | getWord(al, ah);
 		eah = eal + 1;
-		return ((dp.l) ? 4 : 3);
+		return ((dp.l) ? 1 : 0);
 	}
 
-	static uint8_t am_dpix(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dpix(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 
 		register uint16_t	al = (dp.w + (of + x.w + 0));
 		register uint16_t   ah = (dp.w + (of + x.w + 1));
 
 		eal = dbr.a | getWord(al, ah);
 		eah = eal + 1;
-		return ((dp.l) ? 4 : 3);
+		return ((dp.l) ? 1 : 0);
 	}
 
-	static uint8_t am_dpiy(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dpiy(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 
 		register uint16_t	al = (dp.w + (of + 0));
 		register uint16_t   ah = (dp.w + (of + 1));
 
-		eal = (dbr.a | getWord(al, ah)) + y.w;
+		register uint16_t	ad = getWord(al, ah);
+
+		eal = (dbr.a | ad) + y.w;
 		eah = eal + 1;
-		return ((dp.l) ? 4 : 3);
+		return (((dp.l) ? 1 : 0) + ((!p.x || ((ad & 0xff) + y.w > 0xff)) ? 1 : 0));
+	}
+
+	// Direct Page Indirect Indexed Y for stores, which always take the
+	// indexing cycle
+	uint8_t am_dpyw(uint32_t &eal, uint32_t &eah)
+	{
+		am_dpiy(eal, eah);
+		return ((dp.l) ? 1 : 0);
 	}
 
-	static uint8_t am_dpil(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dpil(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 		register uint16_t	al = (dp.w + ((of + 0) & 0xff));
 		register uint16_t   ah = (dp.w + ((of + 1) & 0xff));
 		register uint16_t   au = (dp.w + ((of + 2) & 0xff));
 
-		eal = ((getByte (au) << 16) | getWord (al, ah));
+		eal = getLong(al, ah, au);
 		eah = eal + 1;
-		return (4);
+		return ((dp.l) ? 1 : 0);
 	}
 
-	static uint8_t am_dily(uint32_t &eal, uint32_t &eah)
+	uint8_t am_dily(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		register uint8_t	of = getByte(pbr.a | pc.w++);
+		register uint8_t	of = fetch();
 		register uint16_t	al = (dp.w + ((of + 0) & 0xff));
 		register uint16_t   ah = (dp.w + ((of + 1) & 0xff));
 		register uint16_t   au = (dp.w + ((of + 2) & 0xff));
 
-		eal = ((getByte (au) << 16) | getWord (al, ah)) + y.w;
+		eal = getLong(al, ah, au) + y.w;
 		eah = eal + 1;
-		return (4);
+		return ((dp.l) ? 1 : 0);
 	}
 
-	static uint8_t am_srel(uint32_t &eal, uint32_t &eah)
+	uint8_t am_srel(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
 		register Word		ad = sp;
 
-		ad.w += getByte(pbr.a | pc.w++);
+		ad.w += fetch();
 		eal = ad.w;
 		eah = eal + 1;
-		return (2);
+		return (0);
 	}
 
-	static uint8_t am_sriy(uint32_t &eal, uint32_t &eah)
+	uint8_t am_sriy(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
 		register Word		ad = sp;
 
-		ad.l += getByte(pbr.a | pc.w++);
+		ad.l += fetch();
 
 		register uint8_t	al = getByte(ad.w++);
 		register uint8_t	ah = getByte(ad.w++);
 
 		eal = (dbr.a | (ah << 8) | al) + y.w;
 		eah = eal + 1;
-		return (5);
+		return (0);
 	}
 
-	static uint8_t op_bcc(uint32_t eal, uint32_t eah)
+	uint8_t op_bcc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bcc);
 
 		if (p.c == 0) {
 			pc.w = eal;
-			return (3);
+			return (1);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bcs(uint32_t eal, uint32_t eah)
+	uint8_t op_bcs(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bcs);
 
 		if (p.c == 1) {
 			pc.w = eal;
-			return (3);
+			return (1);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_beq(uint32_t eal, uint32_t eah)
+	uint8_t op_beq(uint32_t eal, uint32_t eah)
 	{
 		TRACE(beq);
 
-		if (p.z == 1) {
+		if (getz()) {
 			pc.w = eal;
-			return (3);
+			return (1);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bmi(uint32_t eal, uint32_t eah)
+	uint8_t op_bmi(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bmi);
 
-		if (p.n == 1) {
+		if (getn()) {
 			pc.w = eal;
-			return (3);
+			return (1);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bne(uint32_t eal, uint32_t eah)
+	uint8_t op_bne(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bne);
 
-		if (p.z == 0) {
+		if (!getz()) {
 			pc.w = eal;
-			return (3);
+			return (1);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bpl(uint32_t eal, uint32_t eah)
+	uint8_t op_bpl(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bpl);
 
-		if (p.n == 0) {
+		if (!getn()) {
 			pc.w = eal;
-			return (3);
+			return (1);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bra(uint32_t eal, uint32_t eah)
+	uint8_t op_bra(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bra);
 
 		pc.w = eal;
-		return (3);
+		return (0);
 	}
 
-	static uint8_t op_brl(uint32_t eal, uint32_t eah)
+	uint8_t op_brl(uint32_t eal, uint32_t eah)
 	{
 		TRACE(brl);
 
 		pc.w = eal;
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_brk(uint32_t eal, uint32_t eah)
+	uint8_t op_brk(uint32_t eal, uint32_t eah)
 	{
 		TRACE(brk);
 
 		pushByte(pbr.b);
 		pushByte(pc.h);
 		pushByte(pc.l);
-		pushByte(p.f);
+		pushByte(getp());
 		p.i = 1;
 		p.d = 0;
 
 		pc.w = getWord(0xffe6, 0xffe7);
 		pbr.b = 0;
-		return (8);
+		return (0);
 	}
 
-	static uint8_t op_bvc(uint32_t eal, uint32_t eah)
+	uint8_t op_bvc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bvc);
 
 		if (p.v == 0) {
 			pc.w = eal;
-			return (3);
+			return (1);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bvs(uint32_t eal, uint32_t eah)
+	uint8_t op_bvs(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bvs);
 
 		if (p.v == 1) {
 			pc.w = eal;
-			return (3);
+			return (1);
 		}
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_cop(uint32_t eal, uint32_t eah)
+	uint8_t op_cop(uint32_t eal, uint32_t eah)
 	{
 		TRACE(cop);
 
 		pushByte(pbr.b);
 		pushByte(pc.h);
 		pushByte(pc.l);
-		pushByte(p.f);
+		pushByte(getp());
 		p.i = 1;
 		p.d = 0;
 
 		pc.w = getWord(0xffe4, 0xffe5);
 		pbr.b = 0;
-		return (8);
+		return (0);
 	}
 
-	static uint8_t op_jsl(uint32_t eal, uint32_t eah)
+	uint8_t op_jsl(uint32_t eal, uint32_t eah)
 	{
 		TRACE(jsl);
 
@@ -2090,10 +2812,10 @@ protected:
 
 		pbr.b = eal >> 16;
 		pc.w = (uint16_t)eal;
-		return (5);
+		return (0);
 	}
 
-	static uint8_t op_jsr(uint32_t eal, uint32_t eah)
+	uint8_t op_jsr(uint32_t eal, uint32_t eah)
 	{
 		TRACE(jsr);
 
@@ -2102,154 +2824,172 @@ protected:
 		pushByte(pc.l);
 
 		pc.w = (uint16_t)eal;
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_mvn(uint32_t eal, uint32_t eah)
+	uint8_t op_mvn(uint32_t eal, uint32_t eah)
 	{
 		TRACE(mvn);
 
 		register uint32_t	dst = getByte(eal) << 16;
 		register uint32_t	src = getByte(eah) << 16;
-
-		setByte(dbr.a = dst | y.w++, getByte(src | x.w++));
-		if (c.w-- != 0x0000) pc.w -= 3;
-		return (7);
+		register uint32_t	size = c.w + 1;
+
+		if (size > 0x10000u - x.w) size = 0x10000 - x.w;
+		if (size > 0x10000u - y.w) size = 0x10000 - y.w;
+		if (size > MOVE_BYTES) size = MOVE_BYTES;
+
+		Memory::copy(dst | y.w, src | x.w, size, true);
+		dbr.a = dst;
+		x.w += size;
+		y.w += size;
+		owed += (size - 1) * (am_immw_CY + op_mvn_CY);
+		if ((c.w -= size) != 0xffff) pc.w -= 3;
+		return (0);
 	}
 
-	static uint8_t op_mvp(uint32_t eal, uint32_t eah)
+	uint8_t op_mvp(uint32_t eal, uint32_t eah)
 	{
 		TRACE(mvp);
 
 		register uint32_t	dst = getByte(eal) << 16;
 		register uint32_t	src = getByte(eah) << 16;
-
-		setByte(dbr.a = dst | y.w--, getByte(src | x.w--));
-		if (c.w-- != 0x0000) pc.w -= 3;
-		return (7);
+		register uint32_t	size = c.w + 1;
+
+		if (size > x.w + 1u) size = x.w + 1;
+		if (size > y.w + 1u) size = y.w + 1;
+		if (size > MOVE_BYTES) size = MOVE_BYTES;
+
+		Memory::copy(dst | (y.w + 1 - size), src | (x.w + 1 - size), size, false);
+		dbr.a = dst;
+		x.w -= size;
+		y.w -= size;
+		owed += (size - 1) * (am_immw_CY + op_mvp_CY);
+		if ((c.w -= size) != 0xffff) pc.w -= 3;
+		return (0);
 	}
 
-	static uint8_t op_pea(uint32_t eal, uint32_t eah)
+	uint8_t op_pea(uint32_t eal, uint32_t eah)
 	{
 		TRACE(pea);
 
 		pushByte(getByte(eah));
 		pushByte(getByte(eal));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_pei(uint32_t eal, uint32_t eah)
+	uint8_t op_pei(uint32_t eal, uint32_t eah)
 	{
 		TRACE(pei);
 
 		pushByte(getByte(eah));
 		pushByte(getByte(eal));
-		return (5);
+		return (0);
 	}
 
-	static uint8_t op_per(uint32_t eal, uint32_t eah)
+	uint8_t op_per(uint32_t eal, uint32_t eah)
 	{
 		TRACE(per);
 
 		pushByte(eal >> 8);
 		pushByte(eal >> 0);
-		return (5);
+		return (0);
 	}
 
-	static uint8_t op_phb(uint32_t eal, uint32_t eah)
+	uint8_t op_phb(uint32_t eal, uint32_t eah)
 	{
 		TRACE(phb);
 
 		pushByte(dbr.b);
-		return (3);
+		return (0);
 	}
 
-	static uint8_t op_phd(uint32_t eal, uint32_t eah)
+	uint8_t op_phd(uint32_t eal, uint32_t eah)
 	{
 		TRACE(phd);
 
 		pushByte(dp.h);
 		pushByte(dp.l);
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_phk(uint32_t eal, uint32_t eah)
+	uint8_t op_phk(uint32_t eal, uint32_t eah)
 	{
 		TRACE(phk);
 
 		pushByte(pbr.b);
-		return (3);
+		return (0);
 	}
 
-	static uint8_t op_php(uint32_t eal, uint32_t eah)
+	uint8_t op_php(uint32_t eal, uint32_t eah)
 	{
 		TRACE(php);
 
-		pushByte(p.f);
-		return (3);
+		pushByte(getp());
+		return (0);
 	}
 
-	static uint8_t op_plb(uint32_t eal, uint32_t eah)
+	uint8_t op_plb(uint32_t eal, uint32_t eah)
 	{
 		TRACE(plb);
 
 		dbr.b = pullByte();
 		setnz_b(dbr.b);
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_pld(uint32_t eal, uint32_t eah)
+	uint8_t op_pld(uint32_t eal, uint32_t eah)
 	{
 		TRACE(pld);
 
 		dp.l = pullByte();
 		dp.h = pullByte();
 		setnz_w(dp.w);
-		return (5);
+		return (0);
 	}
 
-	static uint8_t op_plp(uint32_t eal, uint32_t eah)
+	uint8_t op_plp(uint32_t eal, uint32_t eah)
 	{
 		TRACE(plp);
 
-		p.f = pullByte();
-		Emulator::setMode();
-		return (4);
+		setp(pullByte());
+		setMode();
+		return (0);
 	}
 
-	static uint8_t op_rep(uint32_t eal, uint32_t eah)
+	uint8_t op_rep(uint32_t eal, uint32_t eah)
 	{
 		TRACE(rep);
 
-		p.f &= ~getByte(eal);
-		Emulator::setMode();
-		return (3);
+		setp(getp() & ~getByte(eal));
+		setMode();
+		return (0);
 	}
 
-	static uint8_t op_rts(uint32_t eal, uint32_t eah)
+	uint8_t op_rts(uint32_t eal, uint32_t eah)
 	{
 		TRACE(rts);
 
 		pc.l = pullByte();
 		pc.h = pullByte();
 		++pc.w;
-		return (6);
+		return (0);
 	}
 
-	static uint8_t op_rti(uint32_t eal, uint32_t eah)
+	uint8_t op_rti(uint32_t eal, uint32_t eah)
 	{
 		TRACE(rti);
 
-		p.f = pullByte();
+		setp(pullByte());
 		p.i = 0;
 		pc.l = pullByte();
 		pc.h = pullByte();
 		pbr.b = pullByte();
-		Emulator::setMode();
-		return (7);
+		setMode();
+		return (0);
 	}
 
-	static uint8_t op_rtl(uint32_t eal, uint32_t eah)
+	uint8_t op_rtl(uint32_t eal, uint32_t eah)
 	{
 		TRACE(rtl);
 
@@ -2257,16 +2997,16 @@ protected:
 		pc.h = pullByte();
 		pbr.b = pullByte();
 		++pc.w;
-		return (6);
+		return (0);
 	}
 
-	static uint8_t op_sep(uint32_t eal, uint32_t eah)
+	uint8_t op_sep(uint32_t eal, uint32_t eah)
 	{
 		TRACE(sep);
 
-		p.f |= getByte(eal);
-		Emulator::setMode();
-		return (3);
+		setp(getp() | getByte(eal));
+		setMode();
+		return (0);
 	}
 };
 
@@ -2274,22 +3014,70 @@ protected:
 // Opcodes Affected by M bit
 //------------------------------------------------------------------------------
 
-class ModeM0 : public Registers
+template<class B>
+class ModeM0 : public ModeN<B>
 {
-private:
+protected:
 	ModeM0() { }
 
+	// The fixed cycles of the addressing modes and operations in this class.
+	// Conditional penalties are returned by the functions themselves.
+	enum {
+		am_immm_CY				= 0,
+		op_adc_CY				= 3,
+		op_and_CY				= 3,
+		op_asl_CY				= 4,
+		op_asla_CY				= 2,
+		op_bit_CY				= 3,
+		op_biti_CY				= 3,
+		op_cmp_CY				= 2,
+		op_dec_CY				= 4,
+		op_deca_CY				= 2,
+		op_eor_CY				= 3,
+		op_inc_CY				= 4,
+		op_inca_CY				= 2,
+		op_lda_CY				= 4,
+		op_lsr_CY				= 4,
+		op_lsra_CY				= 2,
+		op_ora_CY				= 3,
+		op_pha_CY				= 5,
+		op_pla_CY				= 2,
+		op_rol_CY				= 4,
+		op_rola_CY				= 2,
+		op_ror_CY				= 4,
+		op_rora_CY				= 2,
+		op_sbc_CY				= 3,
+		op_sta_CY				= 3,
+		op_stz_CY				= 3,
+		op_trb_CY				= 3,
+		op_tsb_CY				= 3,
+		op_txa_CY				= 2,
+		op_tya_CY				= 2
+	};
+
+	using ModeN<B>::c;
+	using ModeN<B>::x;
+	using ModeN<B>::y;
+	using ModeN<B>::p;
+	using ModeN<B>::getWord;
+	using ModeN<B>::setc;
+	using ModeN<B>::setn;
+	using ModeN<B>::setnz_w;
+	using ModeN<B>::setv;
+	using ModeN<B>::setz;
+	using ModeN<B>::skip;
+
 protected:
-	static uint8_t am_immm(uint32_t &eal, uint32_t &eah)
+	uint8_t am_immm(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		eal = pbr.a | pc.w++;
-		eah = pbr.a | pc.w++;
+		eal = skip();
+		eah = skip();
 		return (0);
 	}
 
-	static uint8_t op_adc(uint32_t eal, uint32_t eah)
+	uint8_t op_adc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(adc);
 
@@ -2306,188 +3094,188 @@ protected:
 		setc(temp & 0x10000);
 		setv((~(c.w ^ data)) & (c.w ^ temp) & 0x8000);
 		setnz_w(c.w = (uint16_t)temp);
-		return (3);
+		return (0);
 	}
 
-	static uint8_t op_and(uint32_t eal, uint32_t eah)
+	uint8_t op_and(uint32_t eal, uint32_t eah)
 	{
 		TRACE(and);
 
-		setnz_w(c.w &= ModeN::getWord(eal, eah));
-		return (3);
+		setnz_w(c.w &= ModeN<B>::getWord(eal, eah));
+		return (0);
 	}
 
-	static uint8_t op_asl(uint32_t eal, uint32_t eah)
+	uint8_t op_asl(uint32_t eal, uint32_t eah)
 	{
 		TRACE(asl);
 
-		register uint16_t data = ModeN::getWord(eal, eah);
+		register uint16_t data = ModeN<B>::getWord(eal, eah);
 
 		setc(data & 0x8000);
 		setnz_w(data <<= 1);
-		ModeN::setWord(eal, eah, data);
-		return (4);
+		ModeN<B>::setWord(eal, eah, data);
+		return (0);
 	}
 
-	static uint8_t op_asla(uint32_t eal, uint32_t eah)
+	uint8_t op_asla(uint32_t eal, uint32_t eah)
 	{
 		TRACE(asl);
 
 		setc(c.w & 0x8000);
 		setnz_w(c.w <<= 1);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bit(uint32_t eal, uint32_t eah)
+	uint8_t op_bit(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bit);
 
-		register uint16_t data = ModeN::getWord(eal, eah);
+		register uint16_t data = ModeN<B>::getWord(eal, eah);
 
 		setn(data & 0x8000);
 		setv(data & 0x4000);
 		setz((data & c.w) == 0x0000);
-		return (3);
+		return (0);
 	}
 
-	static uint8_t op_biti(uint32_t eal, uint32_t eah)
+	uint8_t op_biti(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bit);
 
-		register uint16_t data = ModeN::getWord(eal, eah);
+		register uint16_t data = ModeN<B>::getWord(eal, eah);
 
 		setz((data & c.w) == 0x0000);
-		return (3);
+		return (0);
 	}
 
-	static uint8_t op_cmp(uint32_t eal, uint32_t eah)
+	uint8_t op_cmp(uint32_t eal, uint32_t eah)
 	{
 		TRACE(cmp);
 
-		register uint16_t data = ModeN::getWord(eal, eah);
+		register uint16_t data = ModeN<B>::getWord(eal, eah);
 		register uint32_t diff = c.w - data;
 
 		setnz_w((uint16_t)diff);
 		setc(diff & 0x10000);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_dec(uint32_t eal, uint32_t eah)
+	uint8_t op_dec(uint32_t eal, uint32_t eah)
 	{
 		TRACE(dec);
 
-		register uint16_t data = ModeN::getWord(eal, eah);
+		register uint16_t data = ModeN<B>::getWord(eal, eah);
 
 		setnz_w(--data);
-		ModeN::setWord(eal, eah, data);
-		return (4);
+		ModeN<B>::setWord(eal, eah, data);
+		return (0);
 	}
 
-	static uint8_t op_deca(uint32_t eal, uint32_t eah)
+	uint8_t op_deca(uint32_t eal, uint32_t eah)
 	{
 		TRACE(dec);
 
 		setnz_w(--c.w);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_eor(uint32_t eal, uint32_t eah)
+	uint8_t op_eor(uint32_t eal, uint32_t eah)
 	{
 		TRACE(eor);
 
-		setnz_w(c.w ^= ModeN::getWord(eal, eah));
-		return (3);
+		setnz_w(c.w ^= ModeN<B>::getWord(eal, eah));
+		return (0);
 	}
 
-	static uint8_t op_inc(uint32_t eal, uint32_t eah)
+	uint8_t op_inc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(inc);
 
-		register uint16_t data = ModeN::getWord(eal, eah);
+		register uint16_t data = ModeN<B>::getWord(eal, eah);
 
 		setnz_w(++data);
-		ModeN::setWord(eal, eah, data);
-		return (4);
+		ModeN<B>::setWord(eal, eah, data);
+		return (0);
 	}
 
-	static uint8_t op_inca(uint32_t eal, uint32_t eah)
+	uint8_t op_inca(uint32_t eal, uint32_t eah)
 	{
 		TRACE(dec);
 
 		setnz_w(++c.w);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_lda(uint32_t eal, uint32_t eah)
+	uint8_t op_lda(uint32_t eal, uint32_t eah)
 	{
 		TRACE(lda);
 
-		setnz_w(c.w = ModeN::getWord(eal, eah));
-		return (4);
+		setnz_w(c.w = ModeN<B>::getWord(eal, eah));
+		return (0);
 	}
 
-	static uint8_t op_lsr(uint32_t eal, uint32_t eah)
+	uint8_t op_lsr(uint32_t eal, uint32_t eah)
 	{
 		TRACE(lsr);
 
-		register uint16_t data = ModeN::getWord(eal, eah);
+		register uint16_t data = ModeN<B>::getWord(eal, eah);
 
 		setc(data & 0x0001);
 		setnz_w(data >>= 1);
-		ModeN::setWord(eal, eah, data);
-		return (4);
+		ModeN<B>::setWord(eal, eah, data);
+		return (0);
 	}
 
-	static uint8_t op_lsra(uint32_t eal, uint32_t eah)
+	uint8_t op_lsra(uint32_t eal, uint32_t eah)
 	{
 		TRACE(lsr);
 
 		setc(c.w & 0x0001);
 		setnz_w(c.w >>= 1);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_ora(uint32_t eal, uint32_t eah)
+	uint8_t op_ora(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ora);
 
-		setnz_w(c.w |= ModeN::getWord(eal, eah));
-		return (3);
+		setnz_w(c.w |= ModeN<B>::getWord(eal, eah));
+		return (0);
 	}
 
-	static uint8_t op_pha(uint32_t eal, uint32_t eah)
+	uint8_t op_pha(uint32_t eal, uint32_t eah)
 	{
 		TRACE(pha);
 
-		ModeN::pushByte(c.h);
-		ModeN::pushByte(c.l);
-		return (5);
+		ModeN<B>::pushByte(c.h);
+		ModeN<B>::pushByte(c.l);
+		return (0);
 	}
 
-	static uint8_t op_pla(uint32_t eal, uint32_t eah)
+	uint8_t op_pla(uint32_t eal, uint32_t eah)
 	{
 		TRACE(pla);
 
-		c.l = ModeN::pullByte();
-		c.h = ModeN::pullByte();
+		c.l = ModeN<B>::pullByte();
+		c.h = ModeN<B>::pullByte();
 		setnz_w(c.w);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_rol(uint32_t eal, uint32_t eah)
+	uint8_t op_rol(uint32_t eal, uint32_t eah)
 	{
 		TRACE(rol);
 
-		register uint16_t data = ModeN::getWord(eal, eah);
+		register uint16_t data = ModeN<B>::getWord(eal, eah);
 		register uint16_t cin = p.c ? 0x0001 : 0x0000;
 
 		setc(data & 0x8000);
 		setnz_w(data = (data << 1) | cin);
-		ModeN::setWord(eal, eah, data);
-		return (4);
+		ModeN<B>::setWord(eal, eah, data);
+		return (0);
 	}
 
-	static uint8_t op_rola(uint32_t eal, uint32_t eah)
+	uint8_t op_rola(uint32_t eal, uint32_t eah)
 	{
 		TRACE(rol);
 
@@ -2495,23 +3283,23 @@ protected:
 
 		setc(c.w & 0x8000);
 		setnz_w(c.w = (c.w << 1) | cin);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_ror(uint32_t eal, uint32_t eah)
+	uint8_t op_ror(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ror);
 
-		register uint16_t data = ModeN::getWord(eal, eah);
+		register uint16_t data = ModeN<B>::getWord(eal, eah);
 		register uint16_t cin = p.c ? 0x8000 : 0x0000;
 
 		setc(data & 0x0001);
 		setnz_w(data = (data >> 1) | cin);
-		ModeN::setWord(eal, eah, data);
-		return (4);
+		ModeN<B>::setWord(eal, eah, data);
+		return (0);
 	}
 
-	static uint8_t op_rora(uint32_t eal, uint32_t eah)
+	uint8_t op_rora(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ror);
 
@@ -2519,10 +3307,10 @@ protected:
 
 		setc(c.w & 0x0001);
 		setnz_w(c.w = (c.w >> 1) | cin);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_sbc(uint32_t eal, uint32_t eah)
+	uint8_t op_sbc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(sbc);
 
@@ -2539,80 +3327,129 @@ protected:
 		setc(temp & 0x10000);
 		setv((~(c.w ^ data)) & (c.w ^ temp) & 0x8000);
 		setnz_w(c.w = (uint16_t)temp);
-		return (3);
+		return (0);
 	}
 
-	static uint8_t op_sta(uint32_t eal, uint32_t eah)
+	uint8_t op_sta(uint32_t eal, uint32_t eah)
 	{
 		TRACE(sta);
 
-		ModeN::setWord(eal, eah, c.w);
-		return (3);
+		ModeN<B>::setWord(eal, eah, c.w);
+		return (0);
 	}
 
-	static uint8_t op_stz(uint32_t eal, uint32_t eah)
+	uint8_t op_stz(uint32_t eal, uint32_t eah)
 	{
 		TRACE(stz);
 
-		ModeN::setWord(eal, eah, 0x0000);
-		return (3);
+		ModeN<B>::setWord(eal, eah, 0x0000);
+		return (0);
 	}
 
-	static uint8_t op_trb(uint32_t eal, uint32_t eah)
+	uint8_t op_trb(uint32_t eal, uint32_t eah)
 	{
 		TRACE(trb);
 
-		register uint16_t data = ModeN::getWord(eal, eah);
+		register uint16_t data = ModeN<B>::getWord(eal, eah);
 
 		setz((data & c.w) == 0x0000);
-		ModeN::setWord(eal, eah, data & ~c.w);
-		return (3);
+		ModeN<B>::setWord(eal, eah, data & ~c.w);
+		return (0);
 	}
 
-	static uint8_t op_tsb(uint32_t eal, uint32_t eah)
+	uint8_t op_tsb(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tsb);
 
-		register uint16_t data = ModeN::getWord(eal, eah);
+		register uint16_t data = ModeN<B>::getWord(eal, eah);
 
 		setz((data & c.w) == 0x0000);
-		ModeN::setWord(eal, eah, data | c.w);
-		return (3);
+		ModeN<B>::setWord(eal, eah, data | c.w);
+		return (0);
 	}
 
-	static uint8_t op_txa(uint32_t eal, uint32_t eah)
+	uint8_t op_txa(uint32_t eal, uint32_t eah)
 	{
 		TRACE(txa);
 
 		setnz_w(c.w = x.w);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tya(uint32_t eal, uint32_t eah)
+	uint8_t op_tya(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tya);
 
 		setnz_w(c.w = y.w);
-		return (2);
+		return (0);
 	}
 };
 
-class ModeM1 : public Registers
+template<class B>
+class ModeM1 : public ModeN<B>
 {
-private:
+protected:
 	ModeM1() { }
 
+	// The fixed cycles of the addressing modes and operations in this class.
+	// Conditional penalties are returned by the functions themselves.
+	enum {
+		am_immm_CY				= 0,
+		op_adc_CY				= 2,
+		op_and_CY				= 2,
+		op_asl_CY				= 4,
+		op_asla_CY				= 2,
+		op_bit_CY				= 2,
+		op_biti_CY				= 2,
+		op_cmp_CY				= 2,
+		op_dec_CY				= 4,
+		op_deca_CY				= 2,
+		op_eor_CY				= 2,
+		op_inc_CY				= 4,
+		op_inca_CY				= 2,
+		op_lda_CY				= 2,
+		op_lsr_CY				= 4,
+		op_lsra_CY				= 2,
+		op_ora_CY				= 2,
+		op_pha_CY				= 2,
+		op_pla_CY				= 2,
+		op_rol_CY				= 4,
+		op_rola_CY				= 2,
+		op_ror_CY				= 4,
+		op_rora_CY				= 2,
+		op_sbc_CY				= 2,
+		op_sta_CY				= 2,
+		op_stz_CY				= 2,
+		op_trb_CY				= 2,
+		op_tsb_CY				= 2,
+		op_txa_CY				= 2,
+		op_tya_CY				= 2
+	};
+
+	using ModeN<B>::c;
+	using ModeN<B>::x;
+	using ModeN<B>::y;
+	using ModeN<B>::p;
+	using ModeN<B>::getByte;
+	using ModeN<B>::setByte;
+	using ModeN<B>::setc;
+	using ModeN<B>::setn;
+	using ModeN<B>::setnz_b;
+	using ModeN<B>::setv;
+	using ModeN<B>::setz;
+	using ModeN<B>::skip;
+
 protected:
-	static uint8_t am_immm(uint32_t &eal, uint32_t &eah)
+	uint8_t am_immm(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		eal = pbr.a | pc.w++;
+		eal = skip();
 		eah = 0;
 		return (0);
 	}
 
-	static uint8_t op_adc(uint32_t eal, uint32_t eah)
+	uint8_t op_adc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(adc);
 
@@ -2627,61 +3464,61 @@ protected:
 		setc(temp & 0x100);
 		setv((~(c.l ^ data)) & (c.l ^ temp) & 0x80);
 		setnz_b(c.l = (uint8_t)temp);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_and(uint32_t eal, uint32_t eah)
+	uint8_t op_and(uint32_t eal, uint32_t eah)
 	{
 		TRACE(and);
 
 		setnz_b(c.l &= getByte(eal));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_asl(uint32_t eal, uint32_t eah)
+	uint8_t op_asl(uint32_t eal, uint32_t eah)
 	{
 		TRACE(asl);
 
-		register uint8_t data = ModeN::getByte(eal);
+		register uint8_t data = ModeN<B>::getByte(eal);
 
 		setc(data & 0x80);
 		setnz_b(data <<= 1);
 		setByte(eal, data);
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_asla(uint32_t eal, uint32_t eah)
+	uint8_t op_asla(uint32_t eal, uint32_t eah)
 	{
 		TRACE(asl);
 
 		setc(c.l & 0x80);
 		setnz_b(c.l <<= 1);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_bit(uint32_t eal, uint32_t eah)
+	uint8_t op_bit(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bit);
 
-		register uint8_t data = ModeN::getByte(eal);
+		register uint8_t data = ModeN<B>::getByte(eal);
 
 		setn(data & 0x80);
 		setv(data & 0x40);
 		setz((data & c.l) == 0x00);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_biti(uint32_t eal, uint32_t eah)
+	uint8_t op_biti(uint32_t eal, uint32_t eah)
 	{
 		TRACE(bit);
 
-		register uint8_t data = ModeN::getByte(eal);
+		register uint8_t data = ModeN<B>::getByte(eal);
 
 		setz((data & c.l) == 0x00);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_cmp(uint32_t eal, uint32_t eah)
+	uint8_t op_cmp(uint32_t eal, uint32_t eah)
 	{
 		TRACE(cmp);
 
@@ -2690,122 +3527,122 @@ protected:
 
 		setnz_b((uint8_t) diff);
 		setc(!(diff & 0x100));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_dec(uint32_t eal, uint32_t eah)
+	uint8_t op_dec(uint32_t eal, uint32_t eah)
 	{
 		TRACE(dec);
 
-		register uint8_t data = ModeN::getByte(eal);
+		register uint8_t data = ModeN<B>::getByte(eal);
 
 		setnz_b(--data);
-		ModeN::setByte(eal, data);
-		return (4);
+		ModeN<B>::setByte(eal, data);
+		return (0);
 	}
 
-	static uint8_t op_deca(uint32_t eal, uint32_t eah)
+	uint8_t op_deca(uint32_t eal, uint32_t eah)
 	{
 		TRACE(dec);
 
 		setnz_b(--c.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_eor(uint32_t eal, uint32_t eah)
+	uint8_t op_eor(uint32_t eal, uint32_t eah)
 	{
 		TRACE(eor);
 
 		setnz_b(c.l ^= getByte(eal));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_inc(uint32_t eal, uint32_t eah)
+	uint8_t op_inc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(inc);
 
-		register uint8_t data = ModeN::getByte(eal);
+		register uint8_t data = ModeN<B>::getByte(eal);
 
 		setnz_b(++data);
-		ModeN::setByte(eal, data);
-		return (4);
+		ModeN<B>::setByte(eal, data);
+		return (0);
 	}
 
-	static uint8_t op_inca(uint32_t eal, uint32_t eah)
+	uint8_t op_inca(uint32_t eal, uint32_t eah)
 	{
 		TRACE(inc);
 
 		setnz_b(++c.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_lda(uint32_t eal, uint32_t eah)
+	uint8_t op_lda(uint32_t eal, uint32_t eah)
 	{
 		TRACE(lda);
 
 		setnz_b(c.l = getByte(eal));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_lsr(uint32_t eal, uint32_t eah)
+	uint8_t op_lsr(uint32_t eal, uint32_t eah)
 	{
 		TRACE(lsr);
 
-		register uint8_t data = ModeN::getByte(eal);
+		register uint8_t data = ModeN<B>::getByte(eal);
 
 		setc(data & 0x01);
 		setnz_b(data >>= 1);
-		ModeN::setByte(eal, data);
-		return (2);
+		ModeN<B>::setByte(eal, data);
+		return (0);
 	}
 
-	static uint8_t op_lsra(uint32_t eal, uint32_t eah)
+	uint8_t op_lsra(uint32_t eal, uint32_t eah)
 	{
 		TRACE(lsr);
 
 		setc(c.l & 0x01);
 		setnz_b(c.l >>= 1);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_ora(uint32_t eal, uint32_t eah)
+	uint8_t op_ora(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ora);
 
 		setnz_b(c.l |= getByte(eal));
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_pha(uint32_t eal, uint32_t eah)
+	uint8_t op_pha(uint32_t eal, uint32_t eah)
 	{
 		TRACE(pha);
 
-		ModeN::pushByte(c.l);
-		return (2);
+		ModeN<B>::pushByte(c.l);
+		return (0);
 	}
 
-	static uint8_t op_pla(uint32_t eal, uint32_t eah)
+	uint8_t op_pla(uint32_t eal, uint32_t eah)
 	{
 		TRACE(pla);
 
-		c.l = ModeN::pullByte();
-		return (2);
+		c.l = ModeN<B>::pullByte();
+		return (0);
 	}
 
-	static uint8_t op_rol(uint32_t eal, uint32_t eah)
+	uint8_t op_rol(uint32_t eal, uint32_t eah)
 	{
 		TRACE(rol);
 
-		register uint8_t data = ModeN::getByte(eal);
+		register uint8_t data = ModeN<B>::getByte(eal);
 		register uint8_t cin = p.c ? 0x01 : 0x00;
 
 		setc(data & 0x80);
 		setnz_b(data = (data << 1) | cin);
-		ModeN::setByte(eal, data);
-		return (2);
+		ModeN<B>::setByte(eal, data);
+		return (0);
 	}
 
-	static uint8_t op_rola(uint32_t eal, uint32_t eah)
+	uint8_t op_rola(uint32_t eal, uint32_t eah)
 	{
 		TRACE(rol);
 
@@ -2813,23 +3650,23 @@ protected:
 
 		setc(c.l & 0x80);
 		setnz_b(c.l = (c.l << 1) | cin);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_ror(uint32_t eal, uint32_t eah)
+	uint8_t op_ror(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ror);
 
-		register uint8_t data = ModeN::getByte(eal);
+		register uint8_t data = ModeN<B>::getByte(eal);
 		register uint8_t cin = p.c ? 0x80 : 0x00;
 
 		setc(data & 0x01);
 		setnz_b(data = (data >> 1) | cin);
-		ModeN::setByte(eal, data);
-		return (2);
+		ModeN<B>::setByte(eal, data);
+		return (0);
 	}
 
-	static uint8_t op_rora(uint32_t eal, uint32_t eah)
+	uint8_t op_rora(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ror);
 
@@ -2837,10 +3674,10 @@ protected:
 
 		setc(c.l & 0x01);
 		setnz_b(c.l = (c.l >> 1) | cin);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_sbc(uint32_t eal, uint32_t eah)
+	uint8_t op_sbc(uint32_t eal, uint32_t eah)
 	{
 		TRACE(sbc);
 
@@ -2855,61 +3692,61 @@ protected:
 		setc(temp & 0x100);
 		setv((~(c.l ^ data)) & (c.l ^ temp) & 0x80);
 		setnz_b(c.l = (uint8_t)temp);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_sta(uint32_t eal, uint32_t eah)
+	uint8_t op_sta(uint32_t eal, uint32_t eah)
 	{
 		TRACE(sta);
 
-		ModeN::setByte(eal, c.l);
-		return (2);
+		ModeN<B>::setByte(eal, c.l);
+		return (0);
 	}
 
-	static uint8_t op_stz(uint32_t eal, uint32_t eah)
+	uint8_t op_stz(uint32_t eal, uint32_t eah)
 	{
 		TRACE(stz);
 
-		ModeN::setByte(eal, 0x00);
-		return (2);
+		ModeN<B>::setByte(eal, 0x00);
+		return (0);
 	}
 
-	static uint8_t op_trb(uint32_t eal, uint32_t eah)
+	uint8_t op_trb(uint32_t eal, uint32_t eah)
 	{
 		TRACE(trb);
 
-		register uint8_t data = ModeN::getByte(eal);
+		register uint8_t data = ModeN<B>::getByte(eal);
 
 		setz((data & c.l) == 0x00);
-		ModeN::setByte(eal, data & ~c.l);
-		return (2);
+		ModeN<B>::setByte(eal, data & ~c.l);
+		return (0);
 	}
 
-	static uint8_t op_tsb(uint32_t eal, uint32_t eah)
+	uint8_t op_tsb(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tsb);
 
-		register uint8_t data = ModeN::getByte(eal);
+		register uint8_t data = ModeN<B>::getByte(eal);
 
 		setz((data & c.l) == 0x00);
-		ModeN::setByte(eal, data | c.l);
-		return (2);
+		ModeN<B>::setByte(eal, data | c.l);
+		return (0);
 	}
 
-	static uint8_t op_txa(uint32_t eal, uint32_t eah)
+	uint8_t op_txa(uint32_t eal, uint32_t eah)
 	{
 		TRACE(txa);
 
 		setnz_b(c.l = x.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tya(uint32_t eal, uint32_t eah)
+	uint8_t op_tya(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tya);
 
 		setnz_b(c.l = y.l);
-		return (2);
+		return (0);
 	}
 };
 
@@ -2917,379 +3754,456 @@ protected:
 // Opcodes Affected by X bit
 //------------------------------------------------------------------------------
 
-class ModeX0 : public Registers
+// These are templates over the M bit class so that each combination forms a
+// single chain of classes down from the register file.
+
+template<class M>
+class ModeX0 : public M
 {
-private:
+protected:
 	ModeX0() { }
 
-protected:
-	static uint8_t am_immx(uint32_t &eal, uint32_t &eah)
+	// The fixed cycles of the addressing modes and operations in this class.
+	// Conditional penalties are returned by the functions themselves.
+	enum {
+		am_immx_CY				= 0,
+		op_cpx_CY				= 2,
+		op_cpy_CY				= 2,
+		op_dex_CY				= 2,
+		op_dey_CY				= 2,
+		op_inx_CY				= 2,
+		op_iny_CY				= 2,
+		op_ldx_CY				= 4,
+		op_ldy_CY				= 4,
+		op_phx_CY				= 5,
+		op_phy_CY				= 5,
+		op_plx_CY				= 5,
+		op_ply_CY				= 5,
+		op_stx_CY				= 3,
+		op_sty_CY				= 3,
+		op_tax_CY				= 2,
+		op_tay_CY				= 2,
+		op_tsx_CY				= 2,
+		op_txs_CY				= 2,
+		op_txy_CY				= 2,
+		op_tyx_CY				= 2
+	};
+
+	using M::c;
+	using M::p;
+	using M::sp;
+	using M::x;
+	using M::y;
+	using M::pullByte;
+	using M::pushByte;
+	using M::setc;
+	using M::setnz_b;
+	using M::setnz_w;
+	using M::skip;
+	uint8_t am_immx(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(2);
 
-		eal = pbr.a | pc.w++;
-		eah = pbr.a | pc.w++;
+		eal = skip();
+		eah = skip();
 		return (0);
 	}
 
-	static uint8_t op_cpx(uint32_t eal, uint32_t eah)
+	uint8_t op_cpx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(cpx);
 
-		register uint16_t data = ModeN::getWord(eal, eah);
+		register uint16_t data = M::getWord(eal, eah);
 		register uint32_t diff = x.w - data;
 
 		setnz_w(diff);
 		setc(diff & 0x010000);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_cpy(uint32_t eal, uint32_t eah)
+	uint8_t op_cpy(uint32_t eal, uint32_t eah)
 	{
 		TRACE(cpy);
 
-		register uint16_t data = ModeN::getWord(eal, eah);
+		register uint16_t data = M::getWord(eal, eah);
 		register uint32_t diff = y.w - data;
 
 		setnz_w(diff);
 		setc(diff & 0x10000);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_dex(uint32_t eal, uint32_t eah)
+	uint8_t op_dex(uint32_t eal, uint32_t eah)
 	{
 		TRACE(dex);
 
 		setnz_w(--x.w);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_dey(uint32_t eal, uint32_t eah)
+	uint8_t op_dey(uint32_t eal, uint32_t eah)
 	{
 		TRACE(dey);
 
 		setnz_w(--y.w);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_inx(uint32_t eal, uint32_t eah)
+	uint8_t op_inx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(inx);
 
 		setnz_w(++x.w);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_iny(uint32_t eal, uint32_t eah)
+	uint8_t op_iny(uint32_t eal, uint32_t eah)
 	{
 		TRACE(iny);
 
 		setnz_w(++y.w);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_ldx(uint32_t eal, uint32_t eah)
+	uint8_t op_ldx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ldx);
 
-		setnz_w(x.w = ModeN::getWord(eal, eah));
-		return (4);
+		setnz_w(x.w = M::getWord(eal, eah));
+		return (0);
 	}
 
-	static uint8_t op_ldy(uint32_t eal, uint32_t eah)
+	uint8_t op_ldy(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ldy);
 
-		setnz_w(y.w = ModeN::getWord(eal, eah));
-		return (4);
+		setnz_w(y.w = M::getWord(eal, eah));
+		return (0);
 	}
 
-	static uint8_t op_phx(uint32_t eal, uint32_t eah)
+	uint8_t op_phx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(phx);
 
-		ModeN::pushByte(x.h);
-		ModeN::pushByte(x.l);
-		return (5);
+		M::pushByte(x.h);
+		M::pushByte(x.l);
+		return (0);
 	}
 
-	static uint8_t op_phy(uint32_t eal, uint32_t eah)
+	uint8_t op_phy(uint32_t eal, uint32_t eah)
 	{
 		TRACE(phy);
 
-		ModeN::pushByte(y.h);
-		ModeN::pushByte(y.l);
-		return (5);
+		M::pushByte(y.h);
+		M::pushByte(y.l);
+		return (0);
 	}
 
-	static uint8_t op_plx(uint32_t eal, uint32_t eah)
+	uint8_t op_plx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(plx);
 
-		x.l = ModeN::pullByte();
-		x.h = ModeN::pullByte();
+		x.l = M::pullByte();
+		x.h = M::pullByte();
 		setnz_w(x.w);
-		return (5);
+		return (0);
 	}
 
-	static uint8_t op_ply(uint32_t eal, uint32_t eah)
+	uint8_t op_ply(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ply);
 
-		y.l = ModeN::pullByte();
-		y.h = ModeN::pullByte();
+		y.l = M::pullByte();
+		y.h = M::pullByte();
 		setnz_w(y.w);
-		return (5);
+		return (0);
 	}
 
-	static uint8_t op_stx(uint32_t eal, uint32_t eah)
+	uint8_t op_stx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(stx);
 
-		ModeN::setWord(eal, eah, x.w);
-		return (3);
+		M::setWord(eal, eah, x.w);
+		return (0);
 	}
 
-	static uint8_t op_sty(uint32_t eal, uint32_t eah)
+	uint8_t op_sty(uint32_t eal, uint32_t eah)
 	{
 		TRACE(sty);
 
-		ModeN::setWord(eal, eah, y.w);
-		return (3);
+		M::setWord(eal, eah, y.w);
+		return (0);
 	}
 
-	static uint8_t op_tax(uint32_t eal, uint32_t eah)
+	uint8_t op_tax(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tax);
 
 		setnz_w(x.w = p.m ? c.l : c.w);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tay(uint32_t eal, uint32_t eah)
+	uint8_t op_tay(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tay);
 
 		setnz_w(y.w = p.m ? c.l : c.w);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tsx(uint32_t eal, uint32_t eah)
+	uint8_t op_tsx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tsx);
 
 		setnz_w(x.w = sp.w);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_txs(uint32_t eal, uint32_t eah)
+	uint8_t op_txs(uint32_t eal, uint32_t eah)
 	{
 		TRACE(txs);
 
 		sp.w = x.w;
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_txy(uint32_t eal, uint32_t eah)
+	uint8_t op_txy(uint32_t eal, uint32_t eah)
 	{
 		TRACE(txy);
 
 		setnz_w(y.w = x.w);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tyx(uint32_t eal, uint32_t eah)
+	uint8_t op_tyx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tyx);
 
 		setnz_w(x.w = y.w);
-		return (2);
+		return (0);
 	}
 };
 
-class ModeX1 : public Registers
+template<class M>
+class ModeX1 : public M
 {
-private:
+protected:
 	ModeX1() { }
 
-protected:
-	static uint8_t am_immx(uint32_t &eal, uint32_t &eah)
+	// The fixed cycles of the addressing modes and operations in this class.
+	// Conditional penalties are returned by the functions themselves.
+	enum {
+		am_immx_CY				= 0,
+		op_cpx_CY				= 2,
+		op_cpy_CY				= 2,
+		op_dex_CY				= 2,
+		op_dey_CY				= 2,
+		op_inx_CY				= 2,
+		op_iny_CY				= 2,
+		op_ldx_CY				= 3,
+		op_ldy_CY				= 4,
+		op_phx_CY				= 4,
+		op_phy_CY				= 4,
+		op_plx_CY				= 4,
+		op_ply_CY				= 4,
+		op_stx_CY				= 2,
+		op_sty_CY				= 2,
+		op_tax_CY				= 2,
+		op_tay_CY				= 2,
+		op_tsx_CY				= 2,
+		op_txs_CY				= 2,
+		op_txy_CY				= 2,
+		op_tyx_CY				= 2
+	};
+
+	using M::c;
+	using M::p;
+	using M::sp;
+	using M::x;
+	using M::y;
+	using M::pullByte;
+	using M::pushByte;
+	using M::setc;
+	using M::setnz_b;
+	using M::setnz_w;
+	using M::skip;
+	uint8_t am_immx(uint32_t &eal, uint32_t &eah)
 	{
 		BYTES(1);
 
-		eal = pbr.a | pc.w++;
+		eal = skip();
 		eah = 0;
 		return (0);
 	}
 
-	static uint8_t op_cpx(uint32_t eal, uint32_t eah)
+	uint8_t op_cpx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(cpx);
 
-		register uint8_t  data = ModeN::getByte(eal);
+		register uint8_t  data = M::getByte(eal);
 		register uint16_t diff = x.l - data;
 
 		setnz_b((uint8_t) diff);
 		setc(diff & 0x0100);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_cpy(uint32_t eal, uint32_t eah)
+	uint8_t op_cpy(uint32_t eal, uint32_t eah)
 	{
 		TRACE(cpy);
 
-		register uint8_t  data = ModeN::getByte(eal);
+		register uint8_t  data = M::getByte(eal);
 		register uint16_t diff = y.l - data;
 
 		setnz_b((uint8_t) diff);
 		setc(diff & 0x0100);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_dex(uint32_t eal, uint32_t eah)
+	uint8_t op_dex(uint32_t eal, uint32_t eah)
 	{
 		TRACE(dex);
 
 		setnz_b(--x.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_dey(uint32_t eal, uint32_t eah)
+	uint8_t op_dey(uint32_t eal, uint32_t eah)
 	{
 		TRACE(dey);
 
 		setnz_b(--y.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_inx(uint32_t eal, uint32_t eah)
+	uint8_t op_inx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(inx);
 
 		setnz_b(++x.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_iny(uint32_t eal, uint32_t eah)
+	uint8_t op_iny(uint32_t eal, uint32_t eah)
 	{
 		TRACE(iny);
 
 		setnz_b(++y.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_ldx(uint32_t eal, uint32_t eah)
+	uint8_t op_ldx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ldx);
 
-		setnz_b(x.l = ModeN::getByte(eal));
-		return (3);
+		setnz_b(x.l = M::getByte(eal));
+		return (0);
 	}
 
-	static uint8_t op_ldy(uint32_t eal, uint32_t eah)
+	uint8_t op_ldy(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ldy);
 
-		setnz_b(y.l = ModeN::getByte(eal));
-		return (4);
+		setnz_b(y.l = M::getByte(eal));
+		return (0);
 	}
 
-	static uint8_t op_phx(uint32_t eal, uint32_t eah)
+	uint8_t op_phx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(phx);
 
-		ModeN::pushByte(x.l);
-		return (4);
+		M::pushByte(x.l);
+		return (0);
 	}
 
-	static uint8_t op_phy(uint32_t eal, uint32_t eah)
+	uint8_t op_phy(uint32_t eal, uint32_t eah)
 	{
 		TRACE(phy);
 
-		ModeN::pushByte(y.l);
-		return (4);
+		M::pushByte(y.l);
+		return (0);
 	}
 
-	static uint8_t op_plx(uint32_t eal, uint32_t eah)
+	uint8_t op_plx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(plx);
 
-		x.l = ModeN::pullByte();
+		x.l = M::pullByte();
 		setnz_b(x.l);
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_ply(uint32_t eal, uint32_t eah)
+	uint8_t op_ply(uint32_t eal, uint32_t eah)
 	{
 		TRACE(ply);
 
-		y.l = ModeN::pullByte();
+		y.l = M::pullByte();
 		setnz_b(y.l);
-		return (4);
+		return (0);
 	}
 
-	static uint8_t op_stx(uint32_t eal, uint32_t eah)
+	uint8_t op_stx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(stx);
 
-		ModeN::setByte(eal, x.l);
-		return (2);
+		M::setByte(eal, x.l);
+		return (0);
 	}
 
-	static uint8_t op_sty(uint32_t eal, uint32_t eah)
+	uint8_t op_sty(uint32_t eal, uint32_t eah)
 	{
 		TRACE(sty);
 
-		ModeN::setByte(eal, y.l);
-		return (2);
+		M::setByte(eal, y.l);
+		return (0);
 	}
 
-	static uint8_t op_tax(uint32_t eal, uint32_t eah)
+	uint8_t op_tax(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tax);
 
 		setnz_b(x.l = c.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tay(uint32_t eal, uint32_t eah)
+	uint8_t op_tay(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tay);
 
 		setnz_b(y.l = c.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tsx(uint32_t eal, uint32_t eah)
+	uint8_t op_tsx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tsx);
 
 		setnz_b(x.l = sp.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_txs(uint32_t eal, uint32_t eah)
+	uint8_t op_txs(uint32_t eal, uint32_t eah)
 	{
 		TRACE(txs);
 
 		sp.w = x.l;
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_txy(uint32_t eal, uint32_t eah)
+	uint8_t op_txy(uint32_t eal, uint32_t eah)
 	{
 		TRACE(txy);
 
 		setnz_b(y.l = x.l);
-		return (2);
+		return (0);
 	}
 
-	static uint8_t op_tyx(uint32_t eal, uint32_t eah)
+	uint8_t op_tyx(uint32_t eal, uint32_t eah)
 	{
 		TRACE(tyx);
 
 		setnz_b(x.l = y.l);
-		return (2);
+		return (0);
 	}
 };
 
@@ -3297,12 +4211,15 @@ protected:
 // Opcode Sets
 //------------------------------------------------------------------------------
 
+// An opcode costs the fixed cycles of its addressing mode and operation, a
+// constant for each opcode set, plus any penalties the policy keeps.
 #define OPCODE(HX,AM,OP,AD) \
-	static uint8_t op_##HX (void) \
+	uint8_t op_##HX (void) \
 	{ \
 		register uint32_t	eal,eah; \
-		register uint8_t	cycles = AM (eal, eah) + AD; \
-		return (cycles + OP(eal, eah)); \
+		register uint8_t	extra = AM (eal, eah); \
+		extra += OP (eal, eah); \
+		return (AM##_CY + OP##_CY + AD + Cycles::extra(extra)); \
 	}
 
 #define ALL_OPCODES \
@@ -3336,7 +4253,7 @@ protected:
 	OPCODE(1b, am_impl, op_tcs, 0) \
 	OPCODE(1c, am_absl, op_trb, 0) \
 	OPCODE(1d, am_absx, op_ora, 0) \
-	OPCODE(1e, am_absx, op_asl, 0) \
+	OPCODE(1e, am_abxw, op_asl, 0) \
 	OPCODE(1f, am_alnx, op_ora, 0) \
 	OPCODE(20, am_absp, op_jsr, 0) \
 	OPCODE(21, am_dpix, op_and, 0) \
@@ -3368,7 +4285,7 @@ protected:
 	OPCODE(3b, am_impl, op_tsc, 0) \
 	OPCODE(3c, am_absx, op_bit, 0) \
 	OPCODE(3d, am_absx, op_and, 0) \
-	OPCODE(3e, am_absx, op_rol, 0) \
+	OPCODE(3e, am_abxw, op_rol, 0) \
 	OPCODE(3f, am_alnx, op_and, 0) \
 	OPCODE(40, am_impl, op_rti, 0) \
 	OPCODE(41, am_dpix, op_eor, 0) \
@@ -3400,7 +4317,7 @@ protected:
 	OPCODE(5b, am_impl, op_tcd, 0) \
 	OPCODE(5c, am_alng, op_jml, 0) \
 	OPCODE(5d, am_absx, op_eor, 0) \
-	OPCODE(5e, am_absx, op_lsr, 0) \
+	OPCODE(5e, am_abxw, op_lsr, 0) \
 	OPCODE(5f, am_alnx, op_eor, 0) \
 	OPCODE(60, am_impl, op_rts, 0) \
 	OPCODE(61, am_dpix, op_adc, 0) \
@@ -3432,7 +4349,7 @@ protected:
 	OPCODE(7b, am_impl, op_tdc, 0) \
 	OPCODE(7c, am_abxi, op_jmp, 0) \
 	OPCODE(7d, am_absx, op_adc, 0) \
-	OPCODE(7e, am_absx, op_ror, 0) \
+	OPCODE(7e, am_abxw, op_ror, 0) \
 	OPCODE(7f, am_alnx, op_adc, 0) \
 	OPCODE(80, am_rela, op_bra, 0) \
 	OPCODE(81, am_dpix, op_sta, 0) \
@@ -3451,7 +4368,7 @@ protected:
 	OPCODE(8e, am_absl, op_stx, 0) \
 	OPCODE(8f, am_alng, op_sta, 0) \
 	OPCODE(90, am_rela, op_bcc, 0) \
-	OPCODE(91, am_dpiy, op_sta, 0) \
+	OPCODE(91, am_dpyw, op_sta, 0) \
 	OPCODE(92, am_dpgi, op_sta, 0) \
 	OPCODE(93, am_sriy, op_sta, 0) \
 	OPCODE(94, am_dpgx, op_sty, 0) \
@@ -3459,12 +4376,12 @@ protected:
 	OPCODE(96, am_dpgy, op_stx, 0) \
 	OPCODE(97, am_dily, op_sta, 0) \
 	OPCODE(98, am_impl, op_tya, 0) \
-	OPCODE(99, am_absy, op_sta, 0) \
+	OPCODE(99, am_abyw, op_sta, 0) \
 	OPCODE(9a, am_impl, op_txs, 0) \
 	OPCODE(9b, am_impl, op_txy, 0) \
 	OPCODE(9c, am_absl, op_stz, 0) \
-	OPCODE(9d, am_absx, op_sta, 0) \
-	OPCODE(9e, am_absx, op_stz, 0) \
+	OPCODE(9d, am_abxw, op_sta, 0) \
+	OPCODE(9e, am_abxw, op_stz, 0) \
 	OPCODE(9f, am_alnx, op_sta, 0) \
 	OPCODE(a0, am_immx, op_ldy, 0) \
 	OPCODE(a1, am_dpix, op_lda, 0) \
@@ -3528,7 +4445,7 @@ protected:
 	OPCODE(db, am_impl, op_stp, 0) \
 	OPCODE(dc, am_abil, op_jmp, 0) \
 	OPCODE(dd, am_absx, op_cmp, 0) \
-	OPCODE(de, am_absx, op_dec, 0) \
+	OPCODE(de, am_abxw, op_dec, 0) \
 	OPCODE(df, am_alnx, op_cmp, 0) \
 	OPCODE(e0, am_immx, op_cpx, 0) \
 	OPCODE(e1, am_dpix, op_sbc, 0) \
@@ -3560,59 +4477,193 @@ protected:
 	OPCODE(fb, am_impl, op_xce, 0) \
 	OPCODE(fc, am_abxi, op_jsr, 0) \
 	OPCODE(fd, am_absx, op_sbc, 0) \
-	OPCODE(fe, am_absx, op_inc, 0) \
+	OPCODE(fe, am_abxw, op_inc, 0) \
 	OPCODE(ff, am_alnx, op_sbc, 0)
 
 //==============================================================================
 
-class CpuModeE11 : public Common, ModeE
+class CpuModeE11 : public ModeE<Registers>
 {
-	friend class Emulator;
+	friend class Registers;
 private:
 	static const OpcodeSet	opcodeSet;
 
+	bool execute(Slice &slice, uint32_t budget);
+
 protected:
 	ALL_OPCODES
 };
 
-class CpuModeN00 : public Common, ModeN, ModeM0, ModeX0
+class CpuModeN00 : public ModeX0<ModeM0<CpuModeE11> >
 {
-	friend class Emulator;
+	friend class Registers;
 private:
 	static const OpcodeSet	opcodeSet;
 
+	bool execute(Slice &slice, uint32_t budget);
+
 protected:
 	ALL_OPCODES
 };
 
-class CpuModeN01 : public Common, ModeN, ModeM0, ModeX1
+class CpuModeN01 : public ModeX1<ModeM0<CpuModeN00> >
 {
-	friend class Emulator;
+	friend class Registers;
 private:
 	static const OpcodeSet	opcodeSet;
 
+	bool execute(Slice &slice, uint32_t budget);
+
 protected:
 	ALL_OPCODES
 };
 
-class CpuModeN10 : public Common, ModeN, ModeM1, ModeX0
+class CpuModeN10 : public ModeX0<ModeM1<CpuModeN01> >
 {
-	friend class Emulator;
+	friend class Registers;
 private:
 	static const OpcodeSet	opcodeSet;
 
+	bool execute(Slice &slice, uint32_t budget);
+
 protected:
 	ALL_OPCODES
 };
 
-class CpuModeN11 : public Common, ModeN, ModeM1, ModeX1
+class CpuModeN11 : public ModeX1<ModeM1<CpuModeN10> >
 {
-	friend class Emulator;
+	friend class Registers;
 private:
 	static const OpcodeSet	opcodeSet;
 
+	bool execute(Slice &slice, uint32_t budget);
+
 protected:
 	ALL_OPCODES
 };
 
+//==============================================================================
+// Emulator
+//------------------------------------------------------------------------------
+
+class Emulator : public CpuModeN11
+{
+public:
+	Emulator(void) { }
+
+	void reset(void);
+
+	bool save(Stream &stream);
+	bool restore(File &file);
+
+	void fork(const Emulator &parent);
+
+	// Take an IRQ. A processor waiting in WAI has its PC moved past the WAI
+	// first, so it is not waiting while the handler runs and the RTI
+	// returns to the following instruction.
+	uint8_t irq(void)
+	{
+		if (waiting) {
+			waiting = false;
+			++pc.w;
+		}
+		taken();
+		remaining = 0;
+		return ((this->*(pOpcodeSet->pIrq))());
+	}
+
+	uint32_t step(void)
+	{
+		if (ier.f & flags()) {
+			interrupted = true;
+			if (p.i == 0) irq();
+		}
+
+		SHOW_PC();
+		if ((remaining == 0) || (generation != Memory::generation)) {
+			register const Block *pBlock = cache.lookup(pbr.a | pc.w, pOpcodeSet);
+
+			this->pBlock = pBlock;
+			pFetch = pBlock->bytes;
+			remaining = pBlock->count;
+			generation = Memory::generation;
+		}
+
+		--remaining;
+		++pFetch;
+		++pc.w;
+		register uint32_t cycles = ((this->*(pBlock->pOpcode[pBlock->count - remaining - 1]))());
+		SHOW_CY(cycles);
+		cycles += owed;
+		owed = 0;
+		idle(cycles);
+		return (cycles);
+	}
+
+	// Run instructions until the cycle budget is used up, the processor
+	// stops or waits, or an interrupt is ready to be taken. Interrupts are
+	// only taken at the start of a run so devices need only be sampled
+	// between runs.
+	//
+	// A processor waiting for an interrupt that has not arrived, or spinning
+	// in an idle loop, skips to the end of the budget and the skipped cycles
+	// are counted as executed, and also as idle.
+	//
+	// The cycles spent so far are noted at the start of each block so that
+	// a flag raised during the run is timed from where the processor is.
+	Slice run(uint32_t budget)
+	{
+		register Slice	slice = { 0, 0, 0 };
+
+		if (stopped) return (slice);
+
+		if (ier.f & flags()) {
+			interrupted = true;
+			if (p.i == 0) slice.cycles += irq();
+		}
+
+		if (waiting && !interrupted) {
+			slice.cycles = slice.idle = budget;
+			idle(budget);
+			return (slice);
+		}
+		loop.pBlock = NULL;
+
+#if THREADED
+		while (!(this->*(pOpcodeSet->pExecute))(slice, budget))
+			continue;
+#else
+		for (;;) {
+			if ((remaining == 0) || (generation != Memory::generation)) {
+				slice.cycles += owed;
+				owed = 0;
+				spent.store(slice.cycles, std::memory_order_relaxed);
+				if (slice.instructions && isDone(slice.cycles, budget)) break;
+
+				register const Block *pBlock = cache.lookup(pbr.a | pc.w, pOpcodeSet);
+
+				if (pBlock->idle && isIdle(pBlock, slice, budget)) break;
+
+				this->pBlock = pBlock;
+				pFetch = pBlock->bytes;
+				remaining = pBlock->count;
+				generation = Memory::generation;
+			}
+
+			SHOW_PC();
+			--remaining;
+			++pFetch;
+			++pc.w;
+			++slice.instructions;
+
+			register uint8_t cycles = ((this->*(pBlock->pOpcode[pBlock->count - remaining - 1]))());
+			SHOW_CY(cycles);
+			slice.cycles += cycles;
+		}
+#endif
+		idle(slice.cycles);
+		return (slice);
+	}
+};
+
 #endif
@@ -27,15 +27,19 @@
 #define FIFO_H
 
 #include <stdint.h>
+#include <atomic>
 
 //==============================================================================
 
+// A ring buffer with one producer and one consumer, which may be on
+// different cores. Each side only writes its own index and publishes it
+// with a release store after touching the data, so no lock is needed.
 template <uint16_t size> class Fifo
 {
 private:
-    volatile uint16_t   head;
-    volatile uint16_t   tail;
-    volatile uint8_t    data [size];
+    std::atomic<uint16_t>   head;
+    std::atomic<uint16_t>   tail;
+    uint8_t                 data [size];
 
 public:
     // Construct an empty Fifo instance
@@ -43,30 +47,53 @@ public:
         : head(0), tail(0)
     { }
 
-    // Is the Fifo completely full?
+    // Is the Fifo completely full? Called by the producer.
     bool isFull (void) const
     {
-        return ((tail + 1) % size == head);
+        return ((tail.load (std::memory_order_relaxed) + 1) % size == head.load (std::memory_order_acquire));
     }
 
-    // Is the Fifo completely empty?
+    // Is the Fifo completely empty? Called by the consumer.
     bool isEmpty (void) const
     {
-        return (head == tail);
+        return (head.load (std::memory_order_relaxed) == tail.load (std::memory_order_acquire));
+    }
+
+    // Return the number of values in the Fifo
+    uint16_t count (void) const
+    {
+        return ((tail.load (std::memory_order_acquire) + size - head.load (std::memory_order_acquire)) % size);
+    }
+
+    // Return a value without removing it. The index MUST be less than the
+    // count.
+    uint8_t peek (uint16_t index) const
+    {
+        return (data [(head.load (std::memory_order_acquire) + index) % size]);
+    }
+
+    // Discard all the values in the Fifo. Called by the consumer.
+    void clear (void)
+    {
+        head.store (tail.load (std::memory_order_acquire), std::memory_order_release);
     }
 
     // Enqueue a value. The Fifo MUST NOT be full.
     void enqueue (uint8_t value)
     {
-        data [tail] = value;
-        tail = (tail + 1) % size;
+        uint16_t next = tail.load (std::memory_order_relaxed);
+
+        data [next] = value;
+        tail.store ((next + 1) % size, std::memory_order_release);
     }
 
     // Dequeue a value. The Fifo MUST NOT be empty
     uint8_t dequeue (void)
     {
-        uint8_t value = data [head];
-        head = (head + 1) % size;
+        uint16_t next = head.load (std::memory_order_relaxed);
+        uint8_t value = data [next];
+
+        head.store ((next + 1) % size, std::memory_order_release);
         return (value);
     }
  };
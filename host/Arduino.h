@@ -0,0 +1,239 @@
+//==============================================================================
+// Host Arduino Stubs
+//------------------------------------------------------------------------------
+// Just enough of the Arduino core and FreeRTOS to build the emulator and the
+// sketch on a host machine for testing. Serial output goes to stderr unless
+// it is written as UART data, a Stream is held in memory and each task is a
+// std::thread.
+//==============================================================================
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Return the microseconds since an arbitrary start, wrapping as on the ESP32
+inline uint32_t micros (void)
+{
+    return (std::chrono::duration_cast<std::chrono::microseconds> (
+        std::chrono::steady_clock::now ().time_since_epoch ()).count ());
+}
+
+inline void delay (uint32_t ms)
+{
+    std::this_thread::sleep_for (std::chrono::milliseconds (ms));
+}
+
+// A serial port. Text printed goes to stderr. UART data is read from an
+// input string one character time apart at the rate given to begin() and
+// written to an output string.
+class HardwareSerial
+{
+private:
+    std::mutex          lock;
+    std::string         input;
+    std::string         output;
+    size_t              position;
+    uint32_t            perCharacter;
+    uint32_t            nextAt;
+
+public:
+    std::atomic<size_t>     written;
+    std::atomic<uint32_t>   writtenAt;
+
+    HardwareSerial () : position (0), perCharacter (0), nextAt (0), written (0), writtenAt (0) { }
+
+    void begin (uint32_t baud) { perCharacter = 10000000 / baud; }
+
+    int printf (const char *pFormat, ...)
+    {
+        va_list args;
+
+        va_start (args, pFormat);
+        int result = vfprintf (stderr, pFormat, args);
+        va_end (args);
+        return (result);
+    }
+
+    void print (const char *pText) { fputs (pText, stderr); }
+    void println (const char *pText = "") { fprintf (stderr, "%s\n", pText); }
+
+    // Queue characters to be read as UART data
+    void feed (const std::string &text)
+    {
+        std::lock_guard<std::mutex> guard (lock);
+
+        input += text;
+        nextAt = micros ();
+    }
+
+    // Determine if all the queued characters have been read
+    bool isDrained (void)
+    {
+        std::lock_guard<std::mutex> guard (lock);
+
+        return (position == input.size ());
+    }
+
+    // Return a copy of the UART data written
+    std::string transmitted (void)
+    {
+        std::lock_guard<std::mutex> guard (lock);
+
+        return (output);
+    }
+
+    int available (void)
+    {
+        std::lock_guard<std::mutex> guard (lock);
+
+        return ((position < input.size ()) && ((int32_t)(micros () - nextAt) >= 0));
+    }
+
+    int read (void)
+    {
+        std::lock_guard<std::mutex> guard (lock);
+
+        if (position == input.size ()) return (-1);
+        nextAt = micros () + perCharacter;
+        return ((uint8_t) input [position++]);
+    }
+
+    int availableForWrite (void) { return (1); }
+
+    size_t write (uint8_t value)
+    {
+        std::lock_guard<std::mutex> guard (lock);
+
+        output += (char) value;
+        ++written;
+        writtenAt = micros ();
+        return (1);
+    }
+};
+
+extern HardwareSerial Serial;
+
+class EspClass
+{
+public:
+    uint32_t getCpuFreqMHz (void) { return (240); }
+    uint32_t getFreeHeap (void) { return (0); }
+};
+
+extern EspClass ESP;
+
+// A stream held in memory. Reads start at the beginning of what was written
+// and can be cut short to simulate a truncated file.
+class Stream
+{
+public:
+    std::string     data;
+    size_t          offset;
+    size_t          limit;
+
+    Stream () : offset (0), limit (SIZE_MAX) { }
+
+    size_t write (uint8_t value)
+    {
+        data += (char) value;
+        return (1);
+    }
+
+    size_t write (const uint8_t *pData, size_t size)
+    {
+        data.append ((const char *) pData, size);
+        return (size);
+    }
+
+    size_t readBytes (uint8_t *pData, size_t size)
+    {
+        size_t end = (data.size () < limit) ? data.size () : limit;
+        size_t count = (end > offset) ? end - offset : 0;
+
+        if (count > size) count = size;
+        memcpy (pData, data.data () + offset, count);
+        offset += count;
+        return (count);
+    }
+};
+
+//==============================================================================
+// FreeRTOS
+//------------------------------------------------------------------------------
+
+// A task is a detached thread with a notification count. A tick is a
+// millisecond.
+struct Task {
+    std::mutex              lock;
+    std::condition_variable wake;
+    uint32_t                count;
+
+    Task () : count (0) { }
+};
+
+typedef Task   *TaskHandle_t;
+
+#define pdTRUE              1
+#define pdMS_TO_TICKS(MS)   (MS)
+
+inline TaskHandle_t &currentTask (void)
+{
+    static thread_local TaskHandle_t pTask = NULL;
+
+    return (pTask);
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle (void)
+{
+    if (!currentTask ()) currentTask () = new Task ();
+    return (currentTask ());
+}
+
+inline int xTaskCreatePinnedToCore (void (*pCode) (void *), const char *pName, uint32_t stack,
+    void *pArg, uint32_t priority, TaskHandle_t *pHandle, int core)
+{
+    TaskHandle_t pTask = new Task ();
+
+    if (pHandle) *pHandle = pTask;
+    std::thread ([pCode, pArg, pTask] () {
+        currentTask () = pTask;
+        pCode (pArg);
+    }).detach ();
+    return (1);
+}
+
+inline void xTaskNotifyGive (TaskHandle_t pTask)
+{
+    {
+        std::lock_guard<std::mutex> guard (pTask->lock);
+
+        ++pTask->count;
+    }
+    pTask->wake.notify_one ();
+}
+
+inline uint32_t ulTaskNotifyTake (int clear, uint32_t ticks)
+{
+    TaskHandle_t pTask = xTaskGetCurrentTaskHandle ();
+    std::unique_lock<std::mutex> guard (pTask->lock);
+
+    pTask->wake.wait_for (guard, std::chrono::milliseconds (ticks), [pTask] () { return (pTask->count != 0); });
+
+    uint32_t count = pTask->count;
+
+    if (count) pTask->count = clear ? 0 : count - 1;
+    return (count);
+}
+
+#endif
@@ -0,0 +1,80 @@
+//==============================================================================
+// Host File System Stubs
+//------------------------------------------------------------------------------
+// A file is a Stream that can be positioned. Its contents are held in memory
+// and copied back to the file system when a file opened for writing is
+// closed.
+//==============================================================================
+
+#ifndef FS_H
+#define FS_H
+
+#include <Arduino.h>
+
+#include <map>
+
+#define FILE_READ       "r"
+#define FILE_WRITE      "w"
+
+namespace fs
+{
+
+class File : public Stream
+{
+private:
+    std::string    *pStored;
+    bool            writing;
+
+public:
+    File () : pStored (NULL), writing (false) { }
+
+    File (std::string *pStored, bool writing) : pStored (pStored), writing (writing)
+    {
+        if (!writing) data = *pStored;
+    }
+
+    operator bool (void) const { return (pStored != NULL); }
+
+    size_t size (void) const { return (data.size ()); }
+    size_t position (void) const { return (offset); }
+
+    bool seek (uint32_t pos)
+    {
+        if (pos > data.size ()) return (false);
+        offset = pos;
+        return (true);
+    }
+
+    void close (void)
+    {
+        if (pStored && writing) *pStored = data;
+        pStored = NULL;
+    }
+};
+
+// A file system holding each file as a string
+class FS
+{
+private:
+    std::map<std::string, std::string>  files;
+
+public:
+    File open (const char *pPath, const char *pMode = FILE_READ)
+    {
+        if (*pMode == 'w') {
+            files [pPath].clear ();
+            return (File (&files [pPath], true));
+        }
+        if (!exists (pPath)) return (File ());
+        return (File (&files [pPath], false));
+    }
+
+    bool exists (const char *pPath) { return (files.count (pPath) != 0); }
+    bool remove (const char *pPath) { return (files.erase (pPath) != 0); }
+};
+
+}
+
+using fs::File;
+
+#endif
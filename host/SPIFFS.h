@@ -0,0 +1,25 @@
+//==============================================================================
+// Host SPIFFS Stub
+//------------------------------------------------------------------------------
+// The flash file system is held in memory and starts empty on each run.
+//==============================================================================
+
+#ifndef SPIFFS_H
+#define SPIFFS_H
+
+#include <FS.h>
+
+namespace fs
+{
+
+class SPIFFSFS : public FS
+{
+public:
+    bool begin (bool formatOnFail = false) { return (true); }
+};
+
+}
+
+extern fs::SPIFFSFS SPIFFS;
+
+#endif
@@ -0,0 +1,129 @@
+//==============================================================================
+// Host Benchmark
+//------------------------------------------------------------------------------
+// Runs the sketch with each task as a thread. The program in an S28 file is
+// typed into the boot monitor at 115200 baud and started, and the rate the
+// processor executes cycles and instructions is measured from the end of
+// the input to the last character the program prints, along with the rate
+// emulated time passes. The UART output goes to stdout.
+//
+//   bench [mhz [file [start]]]
+//
+// A clock rate of 0 runs in turbo mode.
+//==============================================================================
+
+#include <Arduino.h>
+#include <SPIFFS.h>
+
+#include "Memory.h"
+#include "Emulator.h"
+
+#include <stdlib.h>
+
+#include <fstream>
+#include <sstream>
+
+HardwareSerial  Serial;
+EspClass        ESP;
+fs::SPIFFSFS    SPIFFS;
+
+// The time the program has to print nothing for it to be taken as finished
+// and the longest it may run, in uSec
+#define QUIET_TIME      1000000
+#define RUN_TIME        120000000
+
+// The sketch's entry points and the state the benchmark reads and sets
+void setup (void);
+void loop (void);
+
+extern Emulator                 emulator;
+extern uint32_t                 cycles;
+extern uint32_t                 instructions;
+extern std::atomic<uint32_t>    executed;
+extern std::atomic<uint32_t>    frequency;
+extern std::atomic<bool>        turbo;
+
+// The running counts of emulated cycles, executed cycles and instructions
+struct Counts {
+    uint64_t    cycles;
+    uint64_t    executed;
+    uint64_t    instructions;
+};
+
+int main (int argc, char **argv)
+{
+    uint32_t mhz = (argc > 1) ? atoi (argv [1]) : 8;
+    const char *pFile = (argc > 2) ? argv [2] : "../code/demo1/fibonacci.s28";
+    const char *pStart = (argc > 3) ? argv [3] : "2000";
+
+    std::ifstream file (pFile);
+    std::stringstream text;
+    std::string input;
+
+    if (!file) {
+        fprintf (stderr, "Can't open %s\n", pFile);
+        return (1);
+    }
+    text << file.rdbuf ();
+    for (char ch : text.str ())
+        if (ch != '\r') input += (ch == '\n') ? '\r' : ch;
+    input += std::string ("G ") + pStart + "\r";
+
+    setup ();
+    if (mhz) frequency = mhz * 1000000;
+    turbo = !mhz;
+    Serial.feed (input);
+
+    // The counts are taken when the input has all been read and again each
+    // time more output appears. The sketch's counts wrap, so what each pass
+    // adds to them is summed.
+    bool started = false;
+    size_t written = 0;
+    uint32_t startedAt = micros ();
+    Counts last = { cycles, executed, instructions };
+    Counts total = { 0, 0, 0 };
+    Counts start = total;
+    Counts end = total;
+
+    while (!emulator.isStopped ()) {
+        loop ();
+
+        uint32_t now = micros ();
+
+        total.cycles += (uint32_t)(cycles - last.cycles);
+        total.executed += (uint32_t)(executed - last.executed);
+        total.instructions += (uint32_t)(instructions - last.instructions);
+        last.cycles = cycles;
+        last.executed = executed;
+        last.instructions = instructions;
+
+        if (!started) {
+            if (!Serial.isDrained ()) continue;
+
+            started = true;
+            startedAt = now;
+            Serial.writtenAt = now;
+            start = end = total;
+        }
+        if (written != Serial.written) {
+            written = Serial.written;
+            end = total;
+        }
+        // Another thread writes the output and may have stamped it after now
+        if (((int32_t)(now - Serial.writtenAt) > QUIET_TIME) || (now - startedAt > RUN_TIME)) break;
+    }
+
+    std::string output = Serial.transmitted ();
+    uint32_t elapsed = Serial.writtenAt - startedAt;
+
+    fwrite (output.data (), 1, output.size (), stdout);
+    fflush (stdout);
+
+    fprintf (stderr, "%s: %u bytes in %.3f s, %.1f MHz executed, %.1f MHz emulated, %.1f MIPS\n",
+        (mhz ? "paced" : "turbo"), (unsigned) output.size (), elapsed / 1e6,
+        (double)(end.executed - start.executed) / elapsed, (double)(end.cycles - start.cycles) / elapsed,
+        (double)(end.instructions - start.instructions) / elapsed);
+
+    // The device tasks never return
+    _Exit (0);
+}
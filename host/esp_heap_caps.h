@@ -0,0 +1,149 @@
+//==============================================================================
+// Host Heap Capability Stubs
+//------------------------------------------------------------------------------
+// The internal heap is taken from the host heap and the SPIRAM heap is an
+// arena of 4K pages, the only size the emulator and sketch take from it.
+// Each has its own size, which a test can change to fill a tier. A test can
+// also make every allocation fail to check how the emulator copes with
+// running out, and give reads of SPIRAM blocks a latency so that the slow
+// tier is slow.
+//==============================================================================
+
+#ifndef ESP_HEAP_CAPS_H
+#define ESP_HEAP_CAPS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <map>
+#include <vector>
+
+#define MALLOC_CAP_8BIT         0x0004
+#define MALLOC_CAP_SPIRAM       0x0400
+#define MALLOC_CAP_INTERNAL     0x0800
+
+// The default sizes of the internal and SPIRAM heaps and the size of a
+// page of the SPIRAM arena
+#define HOST_INTERNAL_HEAP      (256 * 1024)
+#define HOST_SPIRAM_HEAP        (4 * 1024 * 1024)
+#define HOST_SPIRAM_PAGE        4096
+
+// Tells the emulator to read slow RAM blocks through spiramWait
+#define HOST_SPIRAM_LATENCY     1
+
+// The size of a heap and how much of it has been allocated
+struct HostHeap {
+    size_t      size;
+    size_t      used;
+};
+
+inline HostHeap &hostHeap (uint32_t caps)
+{
+    static HostHeap internal = { HOST_INTERNAL_HEAP, 0 };
+    static HostHeap spiram = { HOST_SPIRAM_HEAP, 0 };
+
+    return ((caps & MALLOC_CAP_SPIRAM) ? spiram : internal);
+}
+
+// The free pages of the SPIRAM arena, which is allocated on first use
+inline std::vector<void *> &spiramPages (void)
+{
+    static std::vector<void *> pages;
+    static uint8_t *pArena = NULL;
+
+    if (!pArena && (pArena = (uint8_t *) malloc (HOST_SPIRAM_HEAP))) {
+        for (size_t offset = HOST_SPIRAM_HEAP; offset; offset -= HOST_SPIRAM_PAGE)
+            pages.push_back (pArena + offset - HOST_SPIRAM_PAGE);
+    }
+    return (pages);
+}
+
+// The heap and size of each allocated block
+inline std::map<void *, std::pair<uint32_t, size_t> > &hostBlocks (void)
+{
+    static std::map<void *, std::pair<uint32_t, size_t> > blocks;
+
+    return (blocks);
+}
+
+// Set to make all allocations fail
+inline bool &heapExhausted (void)
+{
+    static bool exhausted = false;
+
+    return (exhausted);
+}
+
+// The time in nSec added to each read of a SPIRAM block and the number of
+// reads that have paid it
+inline uint32_t &spiramLatency (void)
+{
+    static uint32_t latency = 0;
+
+    return (latency);
+}
+
+inline uint32_t &spiramReads (void)
+{
+    static uint32_t reads = 0;
+
+    return (reads);
+}
+
+inline void spiramWait (void)
+{
+    std::chrono::steady_clock::time_point until = std::chrono::steady_clock::now ()
+        + std::chrono::nanoseconds (spiramLatency ());
+
+    ++spiramReads ();
+    while (spiramLatency () && (std::chrono::steady_clock::now () < until)) { }
+}
+
+inline void *heap_caps_malloc (size_t size, uint32_t caps)
+{
+    HostHeap &heap = hostHeap (caps);
+    void *pBlock;
+
+    if (heapExhausted () || (heap.used + size > heap.size)) return (NULL);
+    if (caps & MALLOC_CAP_SPIRAM) {
+        if ((size > HOST_SPIRAM_PAGE) || spiramPages ().empty ()) return (NULL);
+        pBlock = spiramPages ().back ();
+        spiramPages ().pop_back ();
+        size = HOST_SPIRAM_PAGE;
+    }
+    else if (!(pBlock = malloc (size)))
+        return (NULL);
+
+    heap.used += size;
+    hostBlocks () [pBlock] = std::make_pair (caps, size);
+    return (pBlock);
+}
+
+// Free a block from either heap. Freeing a SPIRAM page returns it to the
+// arena.
+inline void heap_caps_free (void *pBlock)
+{
+    std::map<void *, std::pair<uint32_t, size_t> >::iterator entry = hostBlocks ().find (pBlock);
+
+    if (entry != hostBlocks ().end ()) {
+        uint32_t caps = entry->second.first;
+
+        hostHeap (caps).used -= entry->second.second;
+        hostBlocks ().erase (entry);
+        if (caps & MALLOC_CAP_SPIRAM) {
+            spiramPages ().push_back (pBlock);
+            return;
+        }
+    }
+    free (pBlock);
+}
+
+inline size_t heap_caps_get_free_size (uint32_t caps)
+{
+    HostHeap &heap = hostHeap (caps);
+
+    return ((heapExhausted () || (heap.used >= heap.size)) ? 0 : heap.size - heap.used);
+}
+
+#endif
@@ -0,0 +1,484 @@
+//==============================================================================
+// Host Tests
+//------------------------------------------------------------------------------
+// Checks of the emulator core that can run on a host machine. Each test
+// loads a small program into RAM, resets the processor to it and steps or
+// runs it.
+//==============================================================================
+
+#include <Arduino.h>
+
+#include "Memory.h"
+#include "Emulator.h"
+
+#include <esp_heap_caps.h>
+#include <FS.h>
+
+#include <vector>
+
+HardwareSerial  Serial;
+
+//==============================================================================
+
+#define PROGRAM         0x0200
+#define HANDLER         0x0300
+#define POINTER         0x0010
+
+static uint8_t  ram [0x10000];
+static uint8_t  device [BLOCK_SIZE];
+static Emulator emulator;
+
+static int      checks;
+static int      failures;
+
+#define CHECK(COND) \
+    do { \
+        ++checks; \
+        if (!(COND)) { \
+            ++failures; \
+            printf ("FAIL %s:%d: %s\n", __FILE__, __LINE__, #COND); \
+        } \
+    } while (0)
+
+#define CHECK_EQUAL(EXPECTED,ACTUAL) \
+    do { \
+        ++checks; \
+        uint32_t expected = (EXPECTED), actual = (ACTUAL); \
+        if (expected != actual) { \
+            ++failures; \
+            printf ("FAIL %s:%d: %s is %u, expected %u\n", __FILE__, __LINE__, #ACTUAL, actual, expected); \
+        } \
+    } while (0)
+
+// The virtual peripherals used by the tests: $01 sets the enabled
+// interrupts, $06 raises and $07 lowers interrupt flags, all from the
+// accumulator.
+uint8_t Registers::op_wdm (uint32_t eal, uint32_t eah)
+{
+    switch (getByte (eal)) {
+    case 0x01:  ier.f = c.w;    break;
+    case 0x06:  raise (c.w);    break;
+    case 0x07:  lower (c.w);    break;
+    }
+    return (0);
+}
+
+// Write bytes into memory as the processor would
+static void poke (uint32_t address, const std::vector<uint8_t> &bytes)
+{
+    for (size_t index = 0; index < bytes.size (); ++index)
+        Memory::setByte (address + index, bytes [index]);
+}
+
+// Load a program, point the reset and IRQ vectors at it and its handler,
+// and reset the processor
+static void load (const std::vector<uint8_t> &program, const std::vector<uint8_t> &handler = std::vector<uint8_t> ())
+{
+    poke (PROGRAM, program);
+    poke (HANDLER, handler);
+    poke (0xfffc, { PROGRAM & 0xff, PROGRAM >> 8, HANDLER & 0xff, HANDLER >> 8 });
+    emulator.lower (0xffff);
+    emulator.reset ();
+}
+
+//==============================================================================
+// Cycle Counts
+//------------------------------------------------------------------------------
+
+// Return the cycles taken by an instruction after a prelude that sets the
+// mode and index registers
+static uint32_t cyclesOf (bool native, uint8_t index, const std::vector<uint8_t> &instruction)
+{
+    std::vector<uint8_t> program;
+    uint32_t prelude = 2;
+
+    if (native) {
+        program.insert (program.end (), { 0x18, 0xfb, 0xe2, 0x30 });   // CLC, XCE, SEP #$30
+        prelude += 3;
+    }
+    program.insert (program.end (), { 0xa2, index, 0xa0, index });     // LDX #, LDY #
+    program.insert (program.end (), instruction.begin (), instruction.end ());
+    program.push_back (0xdb);                                       // STP
+
+    poke (POINTER, { 0x34, 0x12 });
+    load (program);
+    while (prelude--) emulator.step ();
+    return (emulator.step ());
+}
+
+// Stores and read-modify-writes through an indexed address always take the
+// indexing cycle. Loads only take it when a page is crossed.
+static void testIndexedCycles (bool native)
+{
+    static const struct {
+        uint8_t     opcode;
+        uint8_t     cycles;
+    } writes [] = {
+        { 0x9d, 5 },    // STA abs,X
+        { 0x9e, 5 },    // STZ abs,X
+        { 0x99, 5 },    // STA abs,Y
+        { 0x1e, 7 },    // ASL abs,X
+        { 0x3e, 7 },    // ROL abs,X
+        { 0x5e, 7 },    // LSR abs,X
+        { 0x7e, 7 },    // ROR abs,X
+        { 0xde, 7 },    // DEC abs,X
+        { 0xfe, 7 }     // INC abs,X
+    };
+
+    for (size_t index = 0; index < sizeof (writes) / sizeof (writes [0]); ++index) {
+        CHECK_EQUAL (writes [index].cycles, cyclesOf (native, 0x10, { writes [index].opcode, 0x34, 0x12 }));
+        CHECK_EQUAL (writes [index].cycles, cyclesOf (native, 0xf0, { writes [index].opcode, 0x34, 0x12 }));
+    }
+
+    CHECK_EQUAL (6, cyclesOf (native, 0x10, { 0x91, POINTER }));           // STA (dp),Y
+    CHECK_EQUAL (6, cyclesOf (native, 0xf0, { 0x91, POINTER }));
+
+    CHECK_EQUAL (4, cyclesOf (native, 0x10, { 0xbd, 0x34, 0x12 }));        // LDA abs,X
+    CHECK_EQUAL (5, cyclesOf (native, 0xf0, { 0xbd, 0x34, 0x12 }));
+    CHECK_EQUAL (5, cyclesOf (native, 0x10, { 0xb1, POINTER }));           // LDA (dp),Y
+    CHECK_EQUAL (6, cyclesOf (native, 0xf0, { 0xb1, POINTER }));
+}
+
+//==============================================================================
+// Waiting for Interrupts
+//------------------------------------------------------------------------------
+
+// A processor woken from WAI by an IRQ is not waiting while the handler
+// runs, so the handler runs to its RTI and execution continues after the
+// WAI. The handler lowers the flag that woke it.
+static void testWaitInterrupt (void)
+{
+    static const std::vector<uint8_t> program = {
+        0xa9, 0x01, 0x42, 0x01,         // LDA #1, WDM $01
+        0x58, 0xcb,                     // CLI, WAI
+        0xa9, 0x5a, 0x85, 0x40, 0xdb    // LDA #$5A, STA $40, STP
+    };
+    static const std::vector<uint8_t> handler = {
+        0xa9, 0x01, 0x42, 0x07, 0x40    // LDA #1, WDM $07, RTI
+    };
+
+    Memory::setByte (0x40, 0);
+    load (program, handler);
+    for (int count = 0; count < 4; ++count) emulator.step ();
+    CHECK (emulator.isWaiting ());
+    emulator.step ();
+    CHECK (emulator.isWaiting ());
+
+    emulator.raise (1);
+    for (int count = 0; count < 3; ++count) {
+        emulator.step ();
+        CHECK (!emulator.isWaiting ());
+        CHECK (!emulator.isStopped ());
+    }
+    CHECK_EQUAL (0, emulator.flags ());
+    for (int count = 0; count < 3; ++count) emulator.step ();
+    CHECK (emulator.isStopped ());
+    CHECK_EQUAL (0x5a, Memory::getByte (0x40));
+
+    Memory::setByte (0x40, 0);
+    load (program, handler);
+    emulator.run (1000);
+    CHECK (emulator.isWaiting ());
+    emulator.raise (1);
+    emulator.run (1000);
+    CHECK (!emulator.isWaiting ());
+    CHECK (emulator.isStopped ());
+    CHECK_EQUAL (0, emulator.flags ());
+    CHECK_EQUAL (0x5a, Memory::getByte (0x40));
+}
+
+//==============================================================================
+// Interrupt Latency
+//------------------------------------------------------------------------------
+
+// A flag raised by the processor part way through a run is timed from the
+// WDM that raised it, not from the start of the run
+static void testRaiseTime (void)
+{
+    std::vector<uint8_t> program = { 0xa9, 0x01, 0x42, 0x01 };     // LDA #1, WDM $01
+
+    program.insert (program.end (), 20, 0xea);                      // NOP * 20
+    program.insert (program.end (), {
+        0xa9, 0x01, 0x42, 0x06,         // LDA #1, WDM $06
+        0x58, 0xcb                      // CLI, WAI
+    });
+
+    load (program, { 0xdb });
+    emulator.clearLatency ();
+    emulator.run (1000);
+    CHECK (!emulator.isWaiting ());
+    emulator.run (1000);
+    CHECK (emulator.isStopped ());
+    CHECK_EQUAL (2 + 2 + 3, emulator.latency (0).worst);                 // WDM, CLI, WAI
+}
+
+//==============================================================================
+// Saved State
+//------------------------------------------------------------------------------
+
+// The RAM blocks follow the processor state, each preceded by its address
+// as little-endian bytes, and end with a checksum. A truncated or corrupt
+// file, or one there is no memory to restore, leaves the machine as it was.
+static void testSaveRestore (void)
+{
+    std::string stored;
+    File file (&stored, true);
+
+    load ({ 0xdb });
+    Memory::setByte (0x1234, 0x55);
+    Memory::setByte (0x011234, 0x66);
+    CHECK (emulator.save (file));
+
+    uint32_t position = 27, address = 0, blocks = 0;
+
+    while (position + 4 <= file.size ()) {
+        Memory::get ((const uint8_t *) file.data.data () + position, address, 4);
+        position += 4;
+        if (address == 0xffffffff) break;
+        CHECK_EQUAL (0, address & 0xff000fff);
+        position += BLOCK_SIZE;
+        ++blocks;
+    }
+    CHECK_EQUAL (0xffffffff, address);
+    CHECK_EQUAL (file.size (), position + 4);
+    CHECK (blocks >= 3);
+
+    // The allocated block reads as zero again and needs a new block
+    Memory::setByte (0x1234, 0xaa);
+    Memory::remap (0x011000, NULL);
+
+    file.seek (0);
+    file.limit = file.size () - 8;
+    CHECK (!emulator.restore (file));
+    CHECK_EQUAL (0xaa, Memory::getByte (0x1234));
+
+    file.seek (0);
+    file.limit = SIZE_MAX;
+    file.data [27 + 4 + 0x100] ^= 1;
+    CHECK (!emulator.restore (file));
+    CHECK_EQUAL (0xaa, Memory::getByte (0x1234));
+    file.data [27 + 4 + 0x100] ^= 1;
+
+    file.seek (0);
+    heapExhausted () = true;
+    CHECK (!emulator.restore (file));
+    heapExhausted () = false;
+    CHECK_EQUAL (0xaa, Memory::getByte (0x1234));
+    CHECK_EQUAL (0, Memory::getByte (0x011234));
+
+    file.seek (0);
+    CHECK (emulator.restore (file));
+    CHECK_EQUAL (0x55, Memory::getByte (0x1234));
+    CHECK_EQUAL (0x66, Memory::getByte (0x011234));
+    CHECK_EQUAL (file.size (), file.position ());
+}
+
+//==============================================================================
+// Forked Images
+//------------------------------------------------------------------------------
+
+// A forked image gets its own copies of the emulator's RAM blocks as they
+// are written but shares the sketch's RAM, and releasing it returns the
+// blocks it no longer shares
+static void testFork (void)
+{
+    Memory::Image *pParent = Memory::active ();
+
+    Memory::setByte (0x010000, 1);
+    Memory::setByte (0x011000, 1);
+    Memory::setByte (0x020000, 1);
+
+    uint32_t blocks = Memory::tiers.fastBlocks + Memory::tiers.slowBlocks;
+    Memory::Image *pChild = Memory::fork ();
+
+    CHECK (pChild != NULL);
+    CHECK_EQUAL (blocks - 2, Memory::tiers.fastBlocks + Memory::tiers.slowBlocks);
+
+    Memory::select (pChild);
+    Memory::setByte (0x010000, 2);
+    Memory::setByte (0x020000, 2);
+    CHECK_EQUAL (2, Memory::getByte (0x010000));
+    CHECK_EQUAL (1, Memory::getByte (0x011000));
+    CHECK_EQUAL (2, device [0]);
+
+    Memory::select (pParent);
+    CHECK_EQUAL (1, Memory::getByte (0x010000));
+    CHECK_EQUAL (2, Memory::getByte (0x020000));
+    Memory::setByte (0x011000, 3);
+    CHECK_EQUAL (blocks - 2 + 2, Memory::tiers.fastBlocks + Memory::tiers.slowBlocks);
+
+    Memory::release (pChild);
+    CHECK_EQUAL (blocks - 2 + 1, Memory::tiers.fastBlocks + Memory::tiers.slowBlocks);
+    CHECK_EQUAL (1, Memory::getByte (0x010000));
+    CHECK_EQUAL (3, Memory::getByte (0x011000));
+
+    Memory::release (pParent);
+    CHECK_EQUAL (1, Memory::getByte (0x010000));
+}
+
+//==============================================================================
+// Remapped Blocks
+//------------------------------------------------------------------------------
+
+// Remapping a block frees the RAM the emulator had allocated for it, and
+// remapping it to NULL gives it back its own RAM reading as zero
+static void testRemap (void)
+{
+    static uint8_t page [BLOCK_SIZE];
+
+    Memory::setByte (0x01d000, 1);
+
+    uint32_t blocks = Memory::tiers.fastBlocks + Memory::tiers.slowBlocks;
+
+    page [0] = 2;
+    Memory::remap (0x01d000, page);
+    CHECK_EQUAL (blocks - 1, Memory::tiers.fastBlocks + Memory::tiers.slowBlocks);
+    CHECK_EQUAL (2, Memory::getByte (0x01d000));
+
+    Memory::setByte (0x01d000, 3);
+    CHECK_EQUAL (3, page [0]);
+
+    Memory::remap (0x01d000, NULL);
+    CHECK_EQUAL (0, Memory::getByte (0x01d000));
+    Memory::setByte (0x01d000, 4);
+    CHECK_EQUAL (4, Memory::getByte (0x01d000));
+    CHECK_EQUAL (3, page [0]);
+    CHECK_EQUAL (blocks, Memory::tiers.fastBlocks + Memory::tiers.slowBlocks);
+}
+
+// A page can only be mapped into one block at a time, as decoded code read
+// through one block would not see writes through the other
+static void testAlias (void)
+{
+    uint8_t *pPage = (uint8_t *) heap_caps_malloc (BLOCK_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+
+    CHECK (pPage != NULL);
+    memset (pPage, 5, BLOCK_SIZE);
+    CHECK (Memory::remap (0x01d000, pPage));
+    CHECK (Memory::remap (0x01d000, pPage));
+
+    Memory::setByte (0x01e000, 6);
+    CHECK (!Memory::remap (0x01e000, pPage));
+    CHECK_EQUAL (6, Memory::getByte (0x01e000));
+    CHECK (!Memory::remap (0x900000, pPage));
+
+    CHECK (Memory::remap (0x01d000, NULL));
+    CHECK (Memory::remap (0x01e000, pPage));
+    CHECK_EQUAL (5, Memory::getByte (0x01e000));
+
+    CHECK (Memory::remap (0x01e000, NULL));
+    CHECK_EQUAL (0, Memory::getByte (0x01e000));
+    heap_caps_free (pPage);
+}
+
+//==============================================================================
+// Memory Tiers
+//------------------------------------------------------------------------------
+
+// Aging routes the next read of each RAM block through a sampling hook,
+// which is not a device read and so does not stop an idle loop that polls
+// RAM from being seen as idle
+static void testSampledReads (void)
+{
+    Memory::setByte (0x01c000, 5);
+    Memory::age ();
+
+    uint32_t reads = Memory::deviceReads;
+
+    CHECK_EQUAL (5, Memory::getByte (0x01c000));
+    CHECK_EQUAL (reads, Memory::deviceReads);
+}
+
+// A block written while the fast tier is full goes to the slow tier, where
+// its reads pay the PSRAM latency. Each pass counts a hit for every block
+// used since the last and once the slow block is hot it swaps tiers with
+// the coldest fast block.
+static void testTiers (void)
+{
+    HostHeap &internal = hostHeap (MALLOC_CAP_INTERNAL);
+    size_t size = internal.size;
+
+    internal.size = internal.used + FAST_RESERVE + BLOCK_SIZE;
+    spiramLatency () = 1000;
+
+    uint32_t fast = Memory::tiers.fastBlocks, slow = Memory::tiers.slowBlocks;
+
+    Memory::setByte (0x01a000, 1);
+    Memory::setByte (0x01b000, 2);
+    CHECK_EQUAL (fast + 1, Memory::tiers.fastBlocks);
+    CHECK_EQUAL (slow + 1, Memory::tiers.slowBlocks);
+
+    uint32_t reads = spiramReads ();
+
+    CHECK_EQUAL (1, Memory::getByte (0x01a000));
+    CHECK_EQUAL (reads, spiramReads ());
+    CHECK_EQUAL (2, Memory::getByte (0x01b000));
+    CHECK_EQUAL (reads + 1, spiramReads ());
+
+    uint32_t promotions = Memory::tiers.promotions, demotions = Memory::tiers.demotions;
+    uint32_t slowHits = Memory::tiers.slowHits;
+
+    for (int pass = 0; (pass < 8) && (Memory::tiers.promotions == promotions); ++pass) {
+        CHECK_EQUAL (2, Memory::getByte (0x01b000));
+        Memory::age ();
+    }
+    CHECK_EQUAL (promotions + 1, Memory::tiers.promotions);
+    CHECK_EQUAL (demotions + 1, Memory::tiers.demotions);
+    CHECK (Memory::tiers.slowHits > slowHits);
+    CHECK_EQUAL (fast + 1, Memory::tiers.fastBlocks);
+    CHECK_EQUAL (slow + 1, Memory::tiers.slowBlocks);
+
+    reads = spiramReads ();
+    CHECK_EQUAL (2, Memory::getByte (0x01b000));
+    CHECK_EQUAL (reads, spiramReads ());
+
+    internal.size = size;
+    spiramLatency () = 0;
+}
+
+//==============================================================================
+// Running Out of RAM
+//------------------------------------------------------------------------------
+
+// The first write that cannot get a block uses the reserve. After that a
+// write is lost, the exhausted state is latched and the block can still be
+// written once memory is available again.
+static void testExhausted (void)
+{
+    heapExhausted () = true;
+    Memory::setByte (0x01f000, 7);
+    CHECK_EQUAL (7, Memory::getByte (0x01f000));
+    CHECK (!Memory::exhausted);
+
+    Memory::setByte (0x01e000, 8);
+    CHECK_EQUAL (0, Memory::getByte (0x01e000));
+    CHECK (Memory::exhausted);
+
+    heapExhausted () = false;
+    Memory::setByte (0x01e000, 9);
+    CHECK_EQUAL (9, Memory::getByte (0x01e000));
+}
+
+//==============================================================================
+
+int main (int argc, char **argv)
+{
+    Memory::add (0x000000, ram, sizeof (ram));
+    Memory::add (0x010000, 0x10000);
+    Memory::add (0x020000, device, sizeof (device));
+
+    testIndexedCycles (false);
+    testIndexedCycles (true);
+    testWaitInterrupt ();
+    testRaiseTime ();
+    testSaveRestore ();
+    testFork ();
+    testRemap ();
+    testAlias ();
+    testSampledReads ();
+    testTiers ();
+    testExhausted ();
+
+    printf ("%d checks, %d failures\n", checks, failures);
+    return (failures ? 1 : 0);
+}
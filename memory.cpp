@@ -32,30 +32,188 @@
 
 #include "memory.h"
 
+#include <esp_heap_caps.h>
+#include <FS.h>
+
 //==============================================================================
 
-const uint8_t  *Memory::pRd [RAM_BLOCKS + ROM_BLOCKS];
-uint8_t        *Memory::pWr [RAM_BLOCKS + ROM_BLOCKS];
+Memory::Bank   *Memory::pBanks [BANKS];
+Memory::Bank    Memory::unmapped;
+
+const uint8_t   Memory::zeroes [BLOCK_SIZE] = { 0 };
+
+uint32_t        Memory::generation;
+uint32_t        Memory::deviceReads;
+Memory::Tiers   Memory::tiers;
+
+Memory          Memory::memory;
+
+//==============================================================================
+
+// The memory map of the first machine
+Memory::Image   Memory::root;
+Memory::Image  *Memory::pImage = &Memory::root;
+
+// The RAM blocks shared between images
+Memory::Shared *Memory::pShared;
+
+// A block kept back for the first copy-on-write that cannot be allocated,
+// the tier it came from and the latched state once it too has been used
+uint8_t        *Memory::pReserve;
+bool            Memory::reserveSlow;
+bool            Memory::exhausted;
 
 //==============================================================================
 
-// Construct and initialise a Memory instance
+// Construct and initialise a Memory instance. The single static instance
+// points every bank at the shared unmapped bank before anything is added.
 Memory::Memory ()
-{ }
+{
+    for (register int bank = 0; bank < BANKS; ++bank)
+        pBanks [bank] = &unmapped;
+}
+
+// Return the bank holding an address, giving it its own table of blocks if
+// it still shares the unmapped bank. Returns NULL if there is no memory.
+Memory::Bank *Memory::map (uint32_t address)
+{
+    register Bank **ppBank = &pBanks [(address >> 16) & (BANKS - 1)];
+
+    if (*ppBank == &unmapped) {
+        register Bank *pBank = (Bank *) calloc (1, sizeof (Bank));
+
+        if (!pBank) {
+            Serial.printf ("!! Failed to map bank at %.6x\n", address & 0xff0000);
+            return (NULL);
+        }
+        *ppBank = pBank;
+    }
+    return (*ppBank);
+}
+
+// Record the first write to a clean or watched block. The block becomes
+// dirty and if watched its version changes so anything derived from its old
+// contents (e.g. decoded instructions) can be seen to be stale. The shared
+// unmapped bank is never touched.
+void Memory::touch (Bank *pBank, uint32_t block)
+{
+    if (pBank == &unmapped) return;
+    if (pBank->state [block] & WATCHED) {
+        ++pBank->version [block];
+        ++generation;
+    }
+    pBank->state [block] = 0;
+}
+
+// Pass a read from a block with no read pointer to its device. A block that
+// has not been added reads as $FF. RAM whose reads are being sampled has a
+// write pointer and is not counted as a device read, so an idle loop that
+// reads it is still seen to be idle.
+uint8_t Memory::read (uint32_t eal)
+{
+    register Bank *pBank = bankOf (eal);
+    register uint32_t block = blockOf (eal);
+    register IoRead pRead = pBank->pIoRd [block];
+
+    if (!pRead) return (0xff);
+    if (!pBank->pWr [block]) ++deviceReads;
+    return (pRead (eal));
+}
+
+// Return the value left floating on the data bus by a read with nothing to
+// drive it. This is usually the last byte the processor fetched, the high
+// byte of the operand address.
+uint8_t Memory::floating (uint32_t address)
+{
+    return (address >> 8);
+}
+
+// Allocate a RAM block from the slow tier (PSRAM) or the fast tier (internal
+// RAM). The fast tier always leaves FAST_RESERVE bytes free for the rest of
+// the system. Returns NULL if the tier is full.
+uint8_t *Memory::allocate (bool slow)
+{
+    if (slow)
+        return ((uint8_t *) heap_caps_malloc (BLOCK_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+
+    if (heap_caps_get_free_size (MALLOC_CAP_INTERNAL) < FAST_RESERVE + BLOCK_SIZE)
+        return (NULL);
+    return ((uint8_t *) heap_caps_malloc (BLOCK_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+}
 
-// Build a RAM region from dynamically allocated blocks
+// Give a block that still reads a shared block RAM of its own from one of
+// the tiers. The caller fills it.
+void Memory::own (Bank *pBank, uint32_t block, uint8_t *pRAM, bool slow)
+{
+    unshare (pBank->pRd [block]);
+    pBank->pWr [block] = pRAM;
+    pBank->pIoWr [block] = NULL;
+    pBank->owned |= 1 << block;
+    if (slow) {
+        pBank->slow |= 1 << block;
+        ++tiers.slowBlocks;
+    }
+    else {
+        pBank->slow &= ~(1 << block);
+        ++tiers.fastBlocks;
+    }
+    pBank->heat [block] = 0x80;
+    expose (pBank, block);
+}
+
+// Give a RAM block that is still reading a shared block (the zero block or
+// one shared with a forked image) its own copy on its first write. The copy
+// is made in the fast tier if there is room, then the slow tier and finally
+// from the reserve block. The internal RAM the fast tier leaves free for the
+// rest of the system is never used.
+//
+// If there is no memory at all the block keeps reading the shared block
+// and the write is lost. The exhausted state is latched and reported once
+// so the sketch can stop the machine rather than run on with bad memory.
+void Memory::copyOnWrite (uint32_t address, uint8_t value)
+{
+    register Bank *pBank = bankOf (address);
+    register uint32_t block = blockOf (address);
+    register bool slow = false;
+    register uint8_t *pRAM = allocate (false);
+
+    if (!pRAM) pRAM = allocate (slow = true);
+    if (!pRAM) pRAM = pReserve, pReserve = NULL, slow = reserveSlow;
+
+    if (!pRAM) {
+        if (!exhausted) {
+            exhausted = true;
+            Serial.printf ("!! Failed to allocate RAM block at %.6x\n", address & ~(BLOCK_SIZE - 1));
+        }
+        return;
+    }
+
+    memcpy (pRAM, pBank->pRd [block], BLOCK_SIZE);
+    own (pBank, block, pRAM, slow);
+    setByte (address, value);
+}
+
+// Build a RAM region whose blocks read as zero and are allocated when they
+// are first written
 void Memory::add (uint32_t address, int32_t size)
 {
     Serial.printf ("%.6x-%.6x: RAM (Allocated)\n", address, address + size - 1);
 
+    if (!pReserve) pReserve = allocate (reserveSlow = true);
+    if (!pReserve) pReserve = allocate (reserveSlow = false);
+
     for (; size > 0; address += BLOCK_SIZE, size -= BLOCK_SIZE) {
-        register uint32_t block = blockOf (address);
-        register uint8_t *pRAM = (uint8_t *) malloc (BLOCK_SIZE);
+        register Bank *pBank = map (address);
 
-        if (pRAM)
-            pRd [block] = pWr [block] = pRAM;
-        else
-            Serial.printf ("!! Attempt to add NULL RAM block at %.6x", address);
+        if (pBank) {
+            register uint32_t block = blockOf (address);
+
+            pBank->owned &= ~(1 << block);
+            pBank->pRd [block] = zeroes;
+            pBank->pWr [block] = NULL;
+            pBank->pIoRd [block] = NULL;
+            pBank->pIoWr [block] = copyOnWrite;
+        }
     }
 }
 
@@ -66,9 +224,16 @@ void Memory::add (uint32_t address, uint8_t *pRAM, int32_t size)
     
     if (pRAM) {
         for (; size > 0; address += BLOCK_SIZE, pRAM += BLOCK_SIZE, size -= BLOCK_SIZE) {
-            register uint32_t block = blockOf (address);
+            register Bank *pBank = map (address);
+
+            if (pBank) {
+                register uint32_t block = blockOf (address);
 
-            pRd [block] = pWr [block] = pRAM;
+                pBank->owned &= ~(1 << block);
+                pBank->pRd [block] = pBank->pWr [block] = pRAM;
+                pBank->pIoRd [block] = NULL;
+                pBank->pIoWr [block] = NULL;
+            }
         }
     }
     else
@@ -82,12 +247,664 @@ void Memory::add (uint32_t address, const uint8_t *pROM, int32_t size)
 
     if (pROM) {
         for (; size > 0; address += BLOCK_SIZE, pROM += BLOCK_SIZE, size -= BLOCK_SIZE) {
-            register uint32_t block = blockOf (address);
+            register Bank *pBank = map (address);
+
+            if (pBank) {
+                register uint32_t block = blockOf (address);
 
-            pRd [block] = pROM;
-            pWr [block] = NULL;
+                pBank->owned &= ~(1 << block);
+                pBank->pRd [block] = pROM;
+                pBank->pWr [block] = NULL;
+                pBank->pIoRd [block] = NULL;
+                pBank->pIoWr [block] = NULL;
+            }
         }
     }
     else
         Serial.printf ("!! Attempt to add NULL ROM block at %.6x", address);
-}
\ No newline at end of file
+}
+
+// Build a ROM region from a packed image. The blocks of zeroes that were
+// left out of the image all share the zero block.
+void Memory::add (uint32_t address, const PackedRom &rom)
+{
+    Serial.printf ("%.6x-%.6x: ROM (Packed)\n", address, address + rom.blocks * BLOCK_SIZE - 1);
+
+    for (register uint32_t index = 0; index < rom.blocks; ++index, address += BLOCK_SIZE) {
+        register Bank *pBank = map (address);
+
+        if (pBank) {
+            register uint32_t block = blockOf (address);
+
+            pBank->owned &= ~(1 << block);
+            pBank->pRd [block] = rom.pIndex [index] ? rom.pData + (rom.pIndex [index] - 1) * BLOCK_SIZE : zeroes;
+            pBank->pWr [block] = NULL;
+            pBank->pIoRd [block] = NULL;
+            pBank->pIoWr [block] = NULL;
+        }
+    }
+}
+
+// Build an I/O region whose reads and writes are passed to a device. Either
+// function may be NULL if the device ignores writes or reads as $FF.
+void Memory::add (uint32_t address, IoRead pRead, IoWrite pWrite, int32_t size)
+{
+    Serial.printf ("%.6x-%.6x: I/O\n", address, address + size - 1);
+
+    for (; size > 0; address += BLOCK_SIZE, size -= BLOCK_SIZE) {
+        register Bank *pBank = map (address);
+
+        if (pBank) {
+            register uint32_t block = blockOf (address);
+
+            pBank->owned &= ~(1 << block);
+            pBank->pRd [block] = NULL;
+            pBank->pWr [block] = NULL;
+            pBank->pIoRd [block] = pRead;
+            pBank->pIoWr [block] = pWrite;
+        }
+    }
+}
+
+// Replace the memory behind a block of RAM with a 4K block owned by the
+// caller, such as a page of a bank switched expansion, or with NULL give it
+// back its own RAM reading as zero until written. A block the emulator had
+// allocated for it is freed and its contents are lost. Decoded code from
+// the old memory becomes stale.
+//
+// A page can only be behind one block at a time. Decoded code is only
+// checked against the version of the block it was read through, so a write
+// through another block would leave it stale. Returns false, leaving the
+// block as it was, if the page is already mapped elsewhere or the address
+// is not in memory.
+bool Memory::remap (uint32_t address, uint8_t *pBlock)
+{
+    register Bank *pBank = bankOf (address);
+    register uint32_t block = blockOf (address);
+
+    if (pBank == &unmapped) return (false);
+
+    if (pBlock) {
+        for (register uint32_t bank = 0; bank < BANKS; ++bank) {
+            register Bank *pOther = pBanks [bank];
+
+            if (pOther == &unmapped) continue;
+            for (register uint32_t other = 0; other < BANK_BLOCKS; ++other)
+                if ((pOther->pWr [other] == pBlock) && ((pOther != pBank) || (other != block))) return (false);
+        }
+    }
+
+    if (pBank->owned & (1 << block)) {
+        heap_caps_free (pBank->pWr [block]);
+        --((pBank->slow & (1 << block)) ? tiers.slowBlocks : tiers.fastBlocks);
+    }
+    else if (pBank->pIoWr [block] == copyOnWrite)
+        unshare (pBank->pRd [block]);
+
+    pBank->owned &= ~(1 << block);
+    pBank->slow &= ~(1 << block);
+    pBank->pIoRd [block] = NULL;
+    if (pBlock) {
+        pBank->pRd [block] = pBank->pWr [block] = pBlock;
+        pBank->pIoWr [block] = NULL;
+    }
+    else {
+        pBank->pRd [block] = zeroes;
+        pBank->pWr [block] = NULL;
+        pBank->pIoWr [block] = copyOnWrite;
+    }
+    touch (pBank, block);
+    return (true);
+}
+
+// Make whole banks share the blocks of the banks at another address. Both
+// addresses and the size should be multiples of 64K.
+void Memory::mirror (uint32_t address, uint32_t source, int32_t size)
+{
+    Serial.printf ("%.6x-%.6x: Mirror of %.6x\n", address, address + size - 1, source);
+
+    for (; size > 0; address += 0x10000, source += 0x10000, size -= 0x10000) {
+        register Bank *pBank = map (source);
+
+        if (pBank) pBanks [(address >> 16) & (BANKS - 1)] = pBank;
+    }
+}
+
+// Build a region where nothing drives the data bus. Reads return the
+// floating bus value and writes are ignored.
+void Memory::openBus (uint32_t address, int32_t size)
+{
+    Serial.printf ("%.6x-%.6x: Open Bus\n", address, address + size - 1);
+
+    for (; size > 0; address += BLOCK_SIZE, size -= BLOCK_SIZE) {
+        register Bank *pBank = map (address);
+
+        if (pBank) {
+            register uint32_t block = blockOf (address);
+
+            pBank->owned &= ~(1 << block);
+            pBank->pRd [block] = NULL;
+            pBank->pWr [block] = NULL;
+            pBank->pIoRd [block] = floating;
+            pBank->pIoWr [block] = NULL;
+        }
+    }
+}
+
+// Copy a region in the order a run of single byte moves would, ascending or
+// descending. The addresses are the lowest of each region. Spans that lie
+// inside one RAM block and one readable block are moved with memmove unless
+// they overlap in a way that would make the result differ.
+void Memory::copy (uint32_t dst, uint32_t src, uint32_t size, bool ascending)
+{
+    while (size) {
+        register uint32_t length = size;
+        register uint32_t to = dst;
+        register uint32_t from = src;
+
+        if (ascending) {
+            if (length > BLOCK_SIZE - offsetOf (to)) length = BLOCK_SIZE - offsetOf (to);
+            if (length > BLOCK_SIZE - offsetOf (from)) length = BLOCK_SIZE - offsetOf (from);
+        }
+        else {
+            if (length > offsetOf (to + size - 1) + 1) length = offsetOf (to + size - 1) + 1;
+            if (length > offsetOf (from + size - 1) + 1) length = offsetOf (from + size - 1) + 1;
+            to += size - length;
+            from += size - length;
+        }
+
+        register Bank *pBank = bankOf (to);
+        register uint32_t block = blockOf (to);
+        register uint8_t *pDst = pBank->pWr [block];
+        register const uint8_t *pSrc = bankOf (from)->pRd [blockOf (from)];
+
+        if (pDst && pSrc) {
+            pDst += offsetOf (to);
+            pSrc += offsetOf (from);
+        }
+
+        if (pDst && pSrc && (ascending ? !((pSrc < pDst) && (pDst < pSrc + length))
+                                       : !((pDst < pSrc) && (pSrc < pDst + length)))) {
+            memmove (pDst, pSrc, length);
+            if (pBank->state [block]) touch (pBank, block);
+        }
+        else if (ascending) {
+            for (register uint32_t index = 0; index < length; ++index)
+                setByte (to + index, getByte (from + index));
+        }
+        else {
+            for (register uint32_t index = length; index-- > 0;)
+                setByte (to + index, getByte (from + index));
+        }
+
+        size -= length;
+        if (ascending) {
+            dst += length;
+            src += length;
+        }
+    }
+}
+
+// Determine if any RAM block in a region has been written since it was last
+// cleaned. RAM that has never been written is not dirty.
+bool Memory::isDirty (uint32_t address, int32_t size)
+{
+    for (size += offsetOf (address); size > 0; address += BLOCK_SIZE, size -= BLOCK_SIZE) {
+        register Bank *pBank = bankOf (address);
+        register uint32_t block = blockOf (address);
+
+        if (pBank->pWr [block] && !(pBank->state [block] & CLEAN)) return (true);
+    }
+    return (false);
+}
+
+// Mark all the blocks in a region as clean so that the next write to each
+// will make it dirty again.
+void Memory::clean (uint32_t address, int32_t size)
+{
+    for (size += offsetOf (address); size > 0; address += BLOCK_SIZE, size -= BLOCK_SIZE) {
+        register Bank *pBank = bankOf (address);
+
+        if (pBank != &unmapped) pBank->state [blockOf (address)] |= CLEAN;
+    }
+}
+
+// Determine if a bank is a mirror of one earlier in the address space
+bool Memory::isMirror (uint32_t bank)
+{
+    for (register uint32_t other = 0; other < bank; ++other)
+        if (pBanks [other] == pBanks [bank]) return (true);
+    return (false);
+}
+
+// Fold bytes into the checksum of a saved state (32-bit FNV-1a)
+uint32_t Memory::checksum (uint32_t sum, const uint8_t *pData, uint32_t size)
+{
+    while (size--)
+        sum = (sum ^ *pData++) * 16777619;
+    return (sum);
+}
+
+// Write the contents of every RAM block that is not all zeroes to a stream.
+// Each block is preceded by its address as four little-endian bytes and the
+// list ends with an address of $FFFFFFFF followed by a checksum of the
+// addresses and blocks. Returns false if the stream fails.
+bool Memory::save (Stream &stream)
+{
+    uint32_t sum = CHECKSUM_SEED;
+
+    for (register uint32_t bank = 0; bank < BANKS; ++bank) {
+        register Bank *pBank = pBanks [bank];
+
+        if ((pBank == &unmapped) || isMirror (bank)) continue;
+
+        for (register uint32_t block = 0; block < BANK_BLOCKS; ++block) {
+            uint8_t address [4];
+
+            if (!isRAM (pBank, block) || (pBank->pRd [block] == zeroes)) continue;
+
+            register const uint8_t *pData = pBank->pWr [block] ? pBank->pWr [block] : pBank->pRd [block];
+
+            put (address, (bank << 16) | (block << BLOCK_BITS), 4);
+            if ((stream.write (address, sizeof (address)) != sizeof (address))
+                    || (stream.write (pData, BLOCK_SIZE) != BLOCK_SIZE))
+                return (false);
+            sum = checksum (checksum (sum, address, sizeof (address)), pData, BLOCK_SIZE);
+        }
+    }
+
+    uint8_t end [8];
+
+    put (put (end, 0xffffffff, 4), sum, 4);
+    return (stream.write (end, sizeof (end)) == sizeof (end));
+}
+
+// Replace the contents of the RAM with blocks read from a file. RAM blocks
+// that are not in the file are cleared. Every block is marked as dirty and
+// decoded code from it as stale.
+//
+// The file is read twice. The first pass checks every address and the
+// checksum and allocates RAM for the blocks that are still shared, so a
+// truncated, corrupt or mismatched file, or one there is not enough memory
+// for, leaves the memory as it was. The second pass reads the blocks
+// straight into the RAM and only fails if the file does between the
+// passes, leaving the RAM cleared. Returns false if either pass fails.
+bool Memory::restore (File &file)
+{
+    register uint32_t start = file.position ();
+    register Pending *pFree = NULL;
+    register bool valid = false;
+    uint32_t sum = CHECKSUM_SEED;
+    uint8_t buffer [256];
+
+    for (;;) {
+        uint32_t address;
+        uint32_t offset;
+
+        if (file.readBytes (buffer, 4) != 4) break;
+        get (buffer, address, 4);
+        if (address == 0xffffffff) {
+            if (file.readBytes (buffer, 4) != 4) break;
+            get (buffer, address, 4);
+            valid = (address == sum);
+            break;
+        }
+        sum = checksum (sum, buffer, 4);
+        if ((address & 0xff000fff) || !isRAM (bankOf (address), blockOf (address))) break;
+
+        for (offset = 0; offset < BLOCK_SIZE; offset += sizeof (buffer)) {
+            if (file.readBytes (buffer, sizeof (buffer)) != sizeof (buffer)) break;
+            sum = checksum (sum, buffer, sizeof (buffer));
+        }
+        if (offset < BLOCK_SIZE) break;
+
+        if (!bankOf (address)->pWr [blockOf (address)]) {
+            register Pending *pPending = (Pending *) malloc (sizeof (Pending));
+
+            if (!pPending) break;
+            pPending->slow = false;
+            if (!(pPending->pData = allocate (false)))
+                pPending->pData = allocate (pPending->slow = true);
+            if (!pPending->pData) {
+                free (pPending);
+                break;
+            }
+            pPending->pNext = pFree;
+            pFree = pPending;
+        }
+    }
+
+    if (valid) valid = file.seek (start);
+
+    if (valid) {
+        for (register uint32_t bank = 0; bank < BANKS; ++bank) {
+            register Bank *pBank = pBanks [bank];
+
+            for (register uint32_t block = 0; block < BANK_BLOCKS; ++block) {
+                if (pBank->pWr [block])
+                    memset (pBank->pWr [block], 0, BLOCK_SIZE);
+                else if (pBank->pIoWr [block] == copyOnWrite) {
+                    unshare (pBank->pRd [block]);
+                    pBank->pRd [block] = zeroes;
+                }
+                else
+                    continue;
+
+                pBank->state [block] |= WATCHED;
+                touch (pBank, block);
+            }
+        }
+
+        for (;;) {
+            uint32_t address;
+
+            if (file.readBytes (buffer, 4) != 4) {
+                valid = false;
+                break;
+            }
+            get (buffer, address, 4);
+            if (address == 0xffffffff) {
+                valid = (file.readBytes (buffer, 4) == 4);
+                break;
+            }
+
+            register Bank *pBank = bankOf (address);
+            register uint32_t block = blockOf (address);
+
+            if (!pBank->pWr [block] && pFree) {
+                register Pending *pNext = pFree->pNext;
+
+                own (pBank, block, pFree->pData, pFree->slow);
+                free (pFree);
+                pFree = pNext;
+            }
+            if (!pBank->pWr [block] || (file.readBytes (pBank->pWr [block], BLOCK_SIZE) != BLOCK_SIZE)) {
+                valid = false;
+                break;
+            }
+        }
+    }
+
+    while (pFree) {
+        register Pending *pNext = pFree->pNext;
+
+        heap_caps_free (pFree->pData);
+        free (pFree);
+        pFree = pNext;
+    }
+    return (valid);
+}
+
+// Find the record of a block shared between images. Returns NULL if the
+// block is not shared (e.g. the zero block).
+Memory::Shared *Memory::sharedOf (const uint8_t *pData)
+{
+    for (register Shared *pEntry = pShared; pEntry; pEntry = pEntry->pNext)
+        if (pEntry->pData == pData) return (pEntry);
+    return (NULL);
+}
+
+// Note that an image has stopped reading a shared block, freeing it if no
+// other image still reads it
+void Memory::unshare (const uint8_t *pData)
+{
+    for (register Shared **ppEntry = &pShared; *ppEntry; ppEntry = &(*ppEntry)->pNext) {
+        register Shared *pEntry = *ppEntry;
+
+        if (pEntry->pData == pData) {
+            if (--pEntry->users == 0) {
+                *ppEntry = pEntry->pNext;
+                heap_caps_free ((void *) pEntry->pData);
+                free (pEntry);
+            }
+            return;
+        }
+    }
+}
+
+// Create a new image that starts as a copy of the active one. The images
+// share every block. The RAM blocks allocated by the emulator become
+// copy-on-write in both, so an image only gets its own copy of a block
+// when it first writes to it. RAM supplied by the sketch (e.g. video RAM or
+// expansion pool pages) is still written in place and is seen by every
+// image. Returns NULL, leaving the active image unchanged, if there is not
+// enough memory for the new image.
+Memory::Image *Memory::fork (void)
+{
+    register Image *pChild = (Image *) calloc (1, sizeof (Image));
+    register Shared *pSpare = NULL;
+
+    if (!pChild) goto failed;
+
+    // Allocate the new bank tables and share records first so that a
+    // failure can be unwound before anything has changed
+    for (register uint32_t bank = 0; bank < BANKS; ++bank) {
+        register Bank *pBank = pBanks [bank];
+
+        if ((pBank == &unmapped) || isMirror (bank)) continue;
+
+        if (!(pChild->pBanks [bank] = (Bank *) malloc (sizeof (Bank)))) goto failed;
+
+        for (register uint32_t block = 0; block < BANK_BLOCKS; ++block) {
+            if (!(pBank->owned & (1 << block))) continue;
+
+            register Shared *pEntry = (Shared *) malloc (sizeof (Shared));
+
+            if (!pEntry) goto failed;
+            pEntry->pNext = pSpare;
+            pSpare = pEntry;
+        }
+    }
+
+    for (register uint32_t bank = 0; bank < BANKS; ++bank) {
+        register Bank *pBank = pBanks [bank];
+        register Bank *pCopy = pChild->pBanks [bank];
+
+        if (pBank == &unmapped) {
+            pChild->pBanks [bank] = &unmapped;
+            continue;
+        }
+        if (!pCopy) {
+            for (register uint32_t other = 0; other < bank; ++other)
+                if (pBanks [other] == pBank) pChild->pBanks [bank] = pChild->pBanks [other];
+            continue;
+        }
+
+        for (register uint32_t block = 0; block < BANK_BLOCKS; ++block) {
+            if (pBank->owned & (1 << block)) {
+                register Shared *pEntry = pSpare;
+
+                pSpare = pEntry->pNext;
+                pEntry->pNext = pShared;
+                pEntry->pData = pBank->pWr [block];
+                pEntry->users = 2;
+                pShared = pEntry;
+
+                --((pBank->slow & (1 << block)) ? tiers.slowBlocks : tiers.fastBlocks);
+
+                pBank->pRd [block] = pBank->pWr [block];
+                pBank->pWr [block] = NULL;
+                pBank->pIoRd [block] = NULL;
+                pBank->pIoWr [block] = copyOnWrite;
+            }
+            else if (pBank->pIoWr [block] == copyOnWrite) {
+                register Shared *pEntry = sharedOf (pBank->pRd [block]);
+
+                if (pEntry) ++pEntry->users;
+            }
+        }
+        pBank->owned = 0;
+        pBank->slow = 0;
+        *pCopy = *pBank;
+        for (register uint32_t block = 0; block < BANK_BLOCKS; ++block)
+            pCopy->state [block] &= ~WATCHED;
+    }
+    return (pChild);
+
+failed:
+    Serial.printf ("!! Failed to fork memory\n");
+    if (pChild) {
+        for (register uint32_t bank = 0; bank < BANKS; ++bank)
+            free (pChild->pBanks [bank]);
+        free (pChild);
+    }
+    while (pSpare) {
+        register Shared *pNext = pSpare->pNext;
+
+        free (pSpare);
+        pSpare = pNext;
+    }
+    return (NULL);
+}
+
+// Free an image made by fork, along with its bank tables, the blocks it
+// owns and any shared blocks that no other image still reads. The active
+// image and the first machine's image cannot be released.
+void Memory::release (Image *pOld)
+{
+    if (!pOld || (pOld == pImage) || (pOld == &root)) return;
+
+    for (register uint32_t bank = 0; bank < BANKS; ++bank) {
+        register Bank *pBank = pOld->pBanks [bank];
+        register bool mirror = false;
+
+        if (pBank == &unmapped) continue;
+        for (register uint32_t other = 0; other < bank; ++other)
+            if (pOld->pBanks [other] == pBank) mirror = true;
+        if (mirror) continue;
+
+        for (register uint32_t block = 0; block < BANK_BLOCKS; ++block) {
+            if (pBank->owned & (1 << block)) {
+                heap_caps_free (pBank->pWr [block]);
+                --((pBank->slow & (1 << block)) ? tiers.slowBlocks : tiers.fastBlocks);
+            }
+            else if (pBank->pIoWr [block] == copyOnWrite)
+                unshare (pBank->pRd [block]);
+        }
+        free (pBank);
+    }
+    free (pOld);
+}
+
+// Make an image the active memory map. An emulator should only be run while
+// the image it was started on is active.
+void Memory::select (Image *pNext)
+{
+    if (pNext == pImage) return;
+
+    memcpy (pImage->pBanks, pBanks, sizeof (pBanks));
+    memcpy (pBanks, pNext->pBanks, sizeof (pBanks));
+    pImage = pNext;
+    ++generation;
+}
+
+// Let reads of a RAM block use its memory directly. A host whose heap
+// stub models the latency of PSRAM reads a slow block through a hook that
+// adds it instead.
+void Memory::expose (Bank *pBank, uint32_t block)
+{
+#ifdef HOST_SPIRAM_LATENCY
+    if (pBank->slow & (1 << block)) {
+        pBank->pRd [block] = NULL;
+        pBank->pIoRd [block] = slowRead;
+        return;
+    }
+#endif
+    pBank->pRd [block] = pBank->pWr [block];
+    pBank->pIoRd [block] = NULL;
+}
+
+#ifdef HOST_SPIRAM_LATENCY
+// Read a byte from a slow block after the PSRAM latency
+uint8_t Memory::slowRead (uint32_t eal)
+{
+    spiramWait ();
+    return (bankOf (eal)->pWr [blockOf (eal)][offsetOf (eal)]);
+}
+#endif
+
+// Restore the reads of a block on its first read since it was aged
+uint8_t Memory::sample (uint32_t eal)
+{
+    expose (bankOf (eal), blockOf (eal));
+    return (getByte (eal));
+}
+
+// Move a block of RAM to the other tier. Returns false if it is full.
+bool Memory::move (Bank *pBank, uint32_t block, bool slow)
+{
+    register uint8_t *pRAM = allocate (slow);
+
+    if (!pRAM) return (false);
+
+    memcpy (pRAM, pBank->pWr [block], BLOCK_SIZE);
+    heap_caps_free (pBank->pWr [block]);
+    pBank->pWr [block] = pRAM;
+
+    if (slow) {
+        pBank->slow |= 1 << block;
+        --tiers.fastBlocks;
+        ++tiers.slowBlocks;
+        ++tiers.demotions;
+    }
+    else {
+        pBank->slow &= ~(1 << block);
+        --tiers.slowBlocks;
+        ++tiers.fastBlocks;
+        ++tiers.promotions;
+    }
+    if (pBank->pIoRd [block] != sample) expose (pBank, block);
+    return (true);
+}
+
+// Age the RAM blocks allocated by the emulator. A block's heat is shifted
+// down and its top bit set if it was read or written since the last pass.
+// Reads are found by removing each block's read pointer so that its first
+// read goes through sample, and writes by the SAMPLED state bit, so the
+// accesses in between cost nothing extra.
+//
+// The hottest slow block is then promoted to the fast tier, demoting the
+// coldest fast block if there is no room for it.
+void Memory::age (void)
+{
+    static uint32_t epoch = 0;
+
+    register Bank *pHot = NULL;
+    register Bank *pCold = NULL;
+    register uint32_t hot = 0;
+    register uint32_t cold = 0;
+
+    ++epoch;
+    for (register uint32_t bank = 0; bank < BANKS; ++bank) {
+        register Bank *pBank = pBanks [bank];
+
+        if ((pBank == &unmapped) || (pBank->aged == epoch)) continue;
+        pBank->aged = epoch;
+
+        for (register uint32_t block = 0; block < BANK_BLOCKS; ++block) {
+            if (!(pBank->owned & (1 << block))) continue;
+
+            register bool slow = pBank->slow & (1 << block);
+            register bool used = (pBank->pIoRd [block] != sample) || !(pBank->state [block] & SAMPLED);
+
+            pBank->heat [block] = (pBank->heat [block] >> 1) | (used ? 0x80 : 0);
+            if (used) ++(slow ? tiers.slowHits : tiers.fastHits);
+
+            if (slow) {
+                if (!pHot || (pBank->heat [block] > pHot->heat [hot])) pHot = pBank, hot = block;
+            }
+            else {
+                if (!pCold || (pBank->heat [block] < pCold->heat [cold])) pCold = pBank, cold = block;
+            }
+
+            pBank->pRd [block] = NULL;
+            pBank->pIoRd [block] = sample;
+            pBank->state [block] |= SAMPLED;
+        }
+    }
+
+    if (pHot && (pHot->heat [hot] >= PROMOTE_HEAT) && !move (pHot, hot, false)) {
+        if (pCold && (pCold->heat [cold] <= DEMOTE_HEAT) && move (pCold, cold, true))
+            move (pHot, hot, false);
+    }
+}
@@ -28,33 +28,129 @@
 
 #include <stdint.h>
 
-//==============================================================================
+class Stream;
+namespace fs { class File; }
+using fs::File;
 
-// Target Memory size (MUST be a power of 2)
-#define RAM_SIZE            (256 * 1024)
-#define ROM_SIZE            (256 * 1024)
+//==============================================================================
 
 // The size of a memory block (4K)
 #define BLOCK_BITS          12
 #define BLOCK_SIZE          (1 << BLOCK_BITS)
 
-// The number of RAM and ROM blocks
-#define RAM_BLOCKS          (RAM_SIZE / BLOCK_SIZE)
-#define ROM_BLOCKS          (ROM_SIZE / BLOCK_SIZE)
+// The number of 64K banks in the 24-bit address space and blocks in a bank
+#define BANKS               256
+#define BANK_BLOCKS         16
+
+// The internal heap that must be left free when allocating fast RAM blocks
+#define FAST_RESERVE        (32 * 1024)
+
+// The heat a slow block must reach to be promoted and the most a fast block
+// can have to be demoted to make room for it
+#define PROMOTE_HEAT        0xc0
+#define DEMOTE_HEAT         0x0f
+
+// The starting value of the checksum of the RAM in a saved state
+#define CHECKSUM_SEED       2166136261u
+
+// The functions that handle reads and writes to an I/O block
+typedef uint8_t (*IoRead) (uint32_t address);
+typedef void (*IoWrite) (uint32_t address, uint8_t value);
+
+// A ROM image stored as only its 4K blocks that are not all zeroes. The
+// index holds the number of each block in the data plus one, or zero for a
+// block of zeroes.
+struct PackedRom {
+    uint32_t        blocks;
+    const uint8_t  *pIndex;
+    const uint8_t  *pData;
+};
 
 //==============================================================================
 
 class Memory
 {
 private:
-    static const uint8_t  *pRd [RAM_BLOCKS + ROM_BLOCKS];
-    static uint8_t        *pWr [RAM_BLOCKS + ROM_BLOCKS];
+    // The state bits of a block. A write only has to do more than store its
+    // byte if one of these is set.
+    enum {
+        WATCHED     = 0x01,         // Decoded code depends on the block
+        CLEAN       = 0x02,         // Not written since last cleaned
+        SAMPLED     = 0x04          // Not written since last aged
+    };
+
+    // The blocks of a 64K bank. A block has a read and write pointer if it
+    // is RAM, just a read pointer if ROM and neither if I/O or unmapped.
+    struct Bank {
+        const uint8_t  *pRd [BANK_BLOCKS];
+        uint8_t        *pWr [BANK_BLOCKS];
+
+        IoRead          pIoRd [BANK_BLOCKS];
+        IoWrite         pIoWr [BANK_BLOCKS];
+
+        uint8_t         state [BANK_BLOCKS];
+        uint32_t        version [BANK_BLOCKS];
+
+        uint8_t         heat [BANK_BLOCKS];
+        uint16_t        owned;
+        uint16_t        slow;
+        uint32_t        aged;
+    };
+
+    // A RAM block shared by forked images and the number of images still
+    // reading it. It is freed when the last of them copies it or is
+    // released.
+    struct Shared {
+        Shared         *pNext;
+        const uint8_t  *pData;
+        uint32_t        users;
+    };
+
+public:
+    // The statistics of the fast and slow RAM tiers. A hit is counted for
+    // each block found to have been accessed when the blocks are aged.
+    struct Tiers {
+        uint32_t        fastBlocks;
+        uint32_t        slowBlocks;
+        uint32_t        fastHits;
+        uint32_t        slowHits;
+        uint32_t        promotions;
+        uint32_t        demotions;
+    };
+
+    // A complete memory map. The active image's banks are held in pBanks and
+    // copied back when another is selected.
+    struct Image {
+        Bank           *pBanks [BANKS];
+    };
+
+private:
+
+    static Bank          *pBanks [BANKS];
+    static Bank           unmapped;
+
+    static Image          root;
+    static Image         *pImage;
+
+    static Shared        *pShared;
+
+    static uint8_t       *pReserve;
+    static bool           reserveSlow;
+
+    static const uint8_t  zeroes [BLOCK_SIZE];
+
+    static Memory         memory;
 
     Memory ();
 
+    static Bank *bankOf (uint32_t address)
+    {
+        return (pBanks [(address >> 16) & (BANKS - 1)]);
+    }
+
     static uint32_t blockOf (uint32_t address)
     {
-        return ((address >> BLOCK_BITS) & (RAM_BLOCKS + ROM_BLOCKS - 1));
+        return ((address >> BLOCK_BITS) & (BANK_BLOCKS - 1));
     }
 
     static uint32_t offsetOf (uint32_t address)
@@ -62,28 +158,184 @@ private:
         return (address & (BLOCK_SIZE - 1));
     }
 
+    static Bank *map (uint32_t address);
+
+    static void touch (Bank *pBank, uint32_t block);
+
+    static uint8_t floating (uint32_t address);
+    static void own (Bank *pBank, uint32_t block, uint8_t *pRAM, bool slow);
+    static void copyOnWrite (uint32_t address, uint8_t value);
+
+    static bool isRAM (Bank *pBank, uint32_t block)
+    {
+        return (pBank->pWr [block] || (pBank->pIoWr [block] == copyOnWrite));
+    }
+
+    static uint8_t read (uint32_t eal);
+
+    static bool isMirror (uint32_t bank);
+    static uint32_t checksum (uint32_t sum, const uint8_t *pData, uint32_t size);
+
+    static Shared *sharedOf (const uint8_t *pData);
+    static void unshare (const uint8_t *pData);
+
+    // A RAM block allocated while a saved state is checked, to be given to
+    // a block that is still shared once the state is known to be good
+    struct Pending {
+        Pending        *pNext;
+        uint8_t        *pData;
+        bool            slow;
+    };
+
+    static uint8_t *allocate (bool slow);
+    static bool move (Bank *pBank, uint32_t block, bool slow);
+    static void expose (Bank *pBank, uint32_t block);
+    static uint8_t slowRead (uint32_t eal);
+    static uint8_t sample (uint32_t eal);
+
 public:
+    static uint32_t       generation;
+    static uint32_t       deviceReads;
+    static Tiers          tiers;
+    static bool           exhausted;
+
     static void add (uint32_t address, int32_t size);
     static void add (uint32_t address, uint8_t *pRAM, int32_t size);
     static void add (uint32_t address, const uint8_t *pROM, int32_t size);
+    static void add (uint32_t address, const PackedRom &rom);
+    static void add (uint32_t address, IoRead pRead, IoWrite pWrite, int32_t size);
+
+    static bool remap (uint32_t address, uint8_t *pBlock);
+    static void mirror (uint32_t address, uint32_t source, int32_t size);
+    static void openBus (uint32_t address, int32_t size);
+
+    static void copy (uint32_t dst, uint32_t src, uint32_t size, bool ascending);
+
+    static bool isDirty (uint32_t address, int32_t size);
+    static void clean (uint32_t address, int32_t size);
+
+    static bool save (Stream &stream);
+    static bool restore (File &file);
+
+    // Store a value in a state record as little-endian bytes
+    static uint8_t *put (uint8_t *pState, uint32_t value, int bytes)
+    {
+        while (bytes--) {
+            *pState++ = value;
+            value >>= 8;
+        }
+        return (pState);
+    }
+
+    // Extract a little-endian value from a state record
+    static const uint8_t *get (const uint8_t *pState, uint32_t &value, int bytes)
+    {
+        value = 0;
+        for (register int shift = 0; bytes--; shift += 8)
+            value |= *pState++ << shift;
+        return (pState);
+    }
+
+    static Image *fork (void);
+    static void select (Image *pImage);
+    static void release (Image *pImage);
+
+    // Return the active image
+    static Image *active (void)
+    {
+        return (pImage);
+    }
 
+    static void age (void);
+
+    // Get a byte from memory. I/O blocks have no read pointer and are passed
+    // to their device.
     static uint8_t getByte (uint32_t eal)
     {
-        register const uint8_t *pBlock = pRd [blockOf (eal)];
+        register const uint8_t *pBlock = bankOf (eal)->pRd [blockOf (eal)];
 
-        return (pBlock [offsetOf (eal)]);
+        if (pBlock) return (pBlock [offsetOf (eal)]);
+        return (read (eal));
     }
 
+    // Get a word from memory. If the bytes are consecutive and in the same
+    // block only one block lookup is needed.
     static uint16_t getWord (uint32_t eal, uint32_t eah)
     {
+        register const uint8_t *pByte = bankOf (eal)->pRd [blockOf (eal)];
+
+        if (pByte && (eah == eal + 1) && offsetOf (eah)) {
+            pByte += offsetOf (eal);
+            return (pByte [0] | pByte [1] << 8);
+        }
         return (getByte (eal) | getByte (eah) << 8);
     }
 
+    // Get a 24-bit long address from memory, using one block lookup when
+    // possible.
+    static uint32_t getLong (uint32_t eal, uint32_t eah, uint32_t eau)
+    {
+        register const uint8_t *pByte = bankOf (eal)->pRd [blockOf (eal)];
+
+        if (pByte && (eah == eal + 1) && (eau == eal + 2) && (offsetOf (eal) < BLOCK_SIZE - 2)) {
+            pByte += offsetOf (eal);
+            return (pByte [0] | pByte [1] << 8 | pByte [2] << 16);
+        }
+        return (getByte (eal) | getByte (eah) << 8 | getByte (eau) << 16);
+    }
+
+    // Set a byte in memory. Writes to ROM are ignored and writes to I/O
+    // blocks are passed to their device.
     static void setByte (uint32_t eal, uint8_t value)
     {
-        register uint8_t *pBlock = pWr [blockOf (eal)];
+        register Bank *pBank = bankOf (eal);
+        register uint32_t block = blockOf (eal);
+        register uint8_t *pBlock = pBank->pWr [block];
+
+        if (pBlock) {
+            pBlock [offsetOf (eal)] = value;
+            if (pBank->state [block]) touch (pBank, block);
+        }
+        else if (pBank->pIoWr [block])
+            (pBank->pIoWr [block]) (eal, value);
+    }
 
-        if (pBlock) pBlock [offsetOf (eal)] = value;
+    // Set a word in memory, using one block lookup when the bytes are
+    // consecutive and in the same block.
+    static void setWord (uint32_t eal, uint32_t eah, uint16_t value)
+    {
+        register Bank *pBank = bankOf (eal);
+        register uint32_t block = blockOf (eal);
+        register uint8_t *pByte = pBank->pWr [block];
+
+        if (pByte && (eah == eal + 1) && offsetOf (eah)) {
+            pByte += offsetOf (eal);
+            pByte [0] = value;
+            pByte [1] = value >> 8;
+            if (pBank->state [block]) touch (pBank, block);
+        }
+        else {
+            setByte (eal, value);
+            setByte (eah, value >> 8);
+        }
+    }
+
+    // Watch the block holding an address for writes and return its version.
+    // The unmapped bank is shared by every empty bank and is never written
+    // so it is left unwatched.
+    static uint32_t watch (uint32_t address)
+    {
+        register Bank *pBank = bankOf (address);
+        register uint32_t block = blockOf (address);
+
+        if (pBank != &unmapped) pBank->state [block] |= WATCHED;
+        return (pBank->version [block]);
+    }
+
+    // Return the version of the block holding an address
+    static uint32_t versionOf (uint32_t address)
+    {
+        return (bankOf (address)->version [blockOf (address)]);
     }
 };
 #endif
\ No newline at end of file
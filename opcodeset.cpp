@@ -31,63 +31,149 @@
 
 //=============================================================================
 
+// Convert a member of the opcode set class named by CPU into a pointer that
+// can be called on the emulator. Emulator derives from every opcode set
+// class so the conversion is from a base to a derived class member.
+#define OP(HX)		static_cast<Opcode>(&CPU::op_##HX)
+
+#if THREADED
+#define EXECUTE		static_cast<Execute>(&CPU::execute)
+#else
+#define EXECUTE		NULL
+#endif
+
 #define	OPCODE_SET \
-	&do_irq, &do_nmi, &do_abort, \
+	static_cast<Opcode>(&CPU::do_irq), \
+	static_cast<Opcode>(&CPU::do_nmi), \
+	static_cast<Opcode>(&CPU::do_abort), \
+	EXECUTE, \
 	{ \
-		&op_00, &op_01, &op_02, &op_03, &op_04, &op_05, &op_06, &op_07, \
-		&op_08, &op_09, &op_0a, &op_0b, &op_0c, &op_0d, &op_0e, &op_0f, \
-		&op_10, &op_11, &op_12, &op_13, &op_14, &op_15, &op_16, &op_17, \
-		&op_18, &op_19, &op_1a, &op_1b, &op_1c, &op_1d, &op_1e, &op_1f, \
-		&op_20, &op_21, &op_22, &op_23, &op_24, &op_25, &op_26, &op_27, \
-		&op_28, &op_29, &op_2a, &op_2b, &op_2c, &op_2d, &op_2e, &op_2f, \
-		&op_30, &op_31, &op_32, &op_33, &op_34, &op_35, &op_36, &op_37, \
-		&op_38, &op_39, &op_3a, &op_3b, &op_3c, &op_3d, &op_3e, &op_3f, \
-		&op_40, &op_41, &op_42, &op_43, &op_44, &op_45, &op_46, &op_47, \
-		&op_48, &op_49, &op_4a, &op_4b, &op_4c, &op_4d, &op_4e, &op_4f, \
-		&op_50, &op_51, &op_52, &op_53, &op_54, &op_55, &op_56, &op_57, \
-		&op_58, &op_59, &op_5a, &op_5b, &op_5c, &op_5d, &op_5e, &op_5f, \
-		&op_60, &op_61, &op_62, &op_63, &op_64, &op_65, &op_66, &op_67, \
-		&op_68, &op_69, &op_6a, &op_6b, &op_6c, &op_6d, &op_6e, &op_6f, \
-		&op_70, &op_71, &op_72, &op_73, &op_74, &op_75, &op_76, &op_77, \
-		&op_78, &op_79, &op_7a, &op_7b, &op_7c, &op_7d, &op_7e, &op_7f, \
-		&op_80, &op_81, &op_82, &op_83, &op_84, &op_85, &op_86, &op_87, \
-		&op_88, &op_89, &op_8a, &op_8b, &op_8c, &op_8d, &op_8e, &op_8f, \
-		&op_90, &op_91, &op_92, &op_93, &op_94, &op_95, &op_96, &op_97, \
-		&op_98, &op_99, &op_9a, &op_9b, &op_9c, &op_9d, &op_9e, &op_9f, \
-		&op_a0, &op_a1, &op_a2, &op_a3, &op_a4, &op_a5, &op_a6, &op_a7, \
-		&op_a8, &op_a9, &op_aa, &op_ab, &op_ac, &op_ad, &op_ae, &op_af, \
-		&op_b0, &op_b1, &op_b2, &op_b3, &op_b4, &op_b5, &op_b6, &op_b7, \
-		&op_b8, &op_b9, &op_ba, &op_bb, &op_bc, &op_bd, &op_be, &op_bf, \
-		&op_c0, &op_c1, &op_c2, &op_c3, &op_c4, &op_c5, &op_c6, &op_c7, \
-		&op_c8, &op_c9, &op_ca, &op_cb, &op_cc, &op_cd, &op_ce, &op_cf, \
-		&op_d0, &op_d1, &op_d2, &op_d3, &op_d4, &op_d5, &op_d6, &op_d7, \
-		&op_d8, &op_d9, &op_da, &op_db, &op_dc, &op_dd, &op_de, &op_df, \
-		&op_e0, &op_e1, &op_e2, &op_e3, &op_e4, &op_e5, &op_e6, &op_e7, \
-		&op_e8, &op_e9, &op_ea, &op_eb, &op_ec, &op_ed, &op_ee, &op_ef, \
-		&op_f0, &op_f1, &op_f2, &op_f3, &op_f4, &op_f5, &op_f6, &op_f7, \
-		&op_f8, &op_f9, &op_fa, &op_fb, &op_fc, &op_fd, &op_fe, &op_ff  \
+		OP(00), OP(01), OP(02), OP(03), OP(04), OP(05), OP(06), OP(07), \
+		OP(08), OP(09), OP(0a), OP(0b), OP(0c), OP(0d), OP(0e), OP(0f), \
+		OP(10), OP(11), OP(12), OP(13), OP(14), OP(15), OP(16), OP(17), \
+		OP(18), OP(19), OP(1a), OP(1b), OP(1c), OP(1d), OP(1e), OP(1f), \
+		OP(20), OP(21), OP(22), OP(23), OP(24), OP(25), OP(26), OP(27), \
+		OP(28), OP(29), OP(2a), OP(2b), OP(2c), OP(2d), OP(2e), OP(2f), \
+		OP(30), OP(31), OP(32), OP(33), OP(34), OP(35), OP(36), OP(37), \
+		OP(38), OP(39), OP(3a), OP(3b), OP(3c), OP(3d), OP(3e), OP(3f), \
+		OP(40), OP(41), OP(42), OP(43), OP(44), OP(45), OP(46), OP(47), \
+		OP(48), OP(49), OP(4a), OP(4b), OP(4c), OP(4d), OP(4e), OP(4f), \
+		OP(50), OP(51), OP(52), OP(53), OP(54), OP(55), OP(56), OP(57), \
+		OP(58), OP(59), OP(5a), OP(5b), OP(5c), OP(5d), OP(5e), OP(5f), \
+		OP(60), OP(61), OP(62), OP(63), OP(64), OP(65), OP(66), OP(67), \
+		OP(68), OP(69), OP(6a), OP(6b), OP(6c), OP(6d), OP(6e), OP(6f), \
+		OP(70), OP(71), OP(72), OP(73), OP(74), OP(75), OP(76), OP(77), \
+		OP(78), OP(79), OP(7a), OP(7b), OP(7c), OP(7d), OP(7e), OP(7f), \
+		OP(80), OP(81), OP(82), OP(83), OP(84), OP(85), OP(86), OP(87), \
+		OP(88), OP(89), OP(8a), OP(8b), OP(8c), OP(8d), OP(8e), OP(8f), \
+		OP(90), OP(91), OP(92), OP(93), OP(94), OP(95), OP(96), OP(97), \
+		OP(98), OP(99), OP(9a), OP(9b), OP(9c), OP(9d), OP(9e), OP(9f), \
+		OP(a0), OP(a1), OP(a2), OP(a3), OP(a4), OP(a5), OP(a6), OP(a7), \
+		OP(a8), OP(a9), OP(aa), OP(ab), OP(ac), OP(ad), OP(ae), OP(af), \
+		OP(b0), OP(b1), OP(b2), OP(b3), OP(b4), OP(b5), OP(b6), OP(b7), \
+		OP(b8), OP(b9), OP(ba), OP(bb), OP(bc), OP(bd), OP(be), OP(bf), \
+		OP(c0), OP(c1), OP(c2), OP(c3), OP(c4), OP(c5), OP(c6), OP(c7), \
+		OP(c8), OP(c9), OP(ca), OP(cb), OP(cc), OP(cd), OP(ce), OP(cf), \
+		OP(d0), OP(d1), OP(d2), OP(d3), OP(d4), OP(d5), OP(d6), OP(d7), \
+		OP(d8), OP(d9), OP(da), OP(db), OP(dc), OP(dd), OP(de), OP(df), \
+		OP(e0), OP(e1), OP(e2), OP(e3), OP(e4), OP(e5), OP(e6), OP(e7), \
+		OP(e8), OP(e9), OP(ea), OP(eb), OP(ec), OP(ed), OP(ee), OP(ef), \
+		OP(f0), OP(f1), OP(f2), OP(f3), OP(f4), OP(f5), OP(f6), OP(f7), \
+		OP(f8), OP(f9), OP(fa), OP(fb), OP(fc), OP(fd), OP(fe), OP(ff)  \
+	}, \
+	{ \
+		ALL_OPCODES \
 	}
 
+// Redefine OPCODE to produce the total instruction length for each opcode
+// from its addressing mode. Immediate M and X lengths depend on the mode.
+
+#undef OPCODE
+#define OPCODE(HX,AM,OP,AD)	AM##_LEN,
+
+#define am_absi_LEN		3
+#define am_abxi_LEN		3
+#define am_abil_LEN		3
+#define am_alng_LEN		4
+#define am_alnx_LEN		4
+#define am_immb_LEN		2
+#define am_immw_LEN		3
+#define am_impl_LEN		1
+#define am_rela_LEN		2
+#define am_lrel_LEN		3
+#define am_absl_LEN		3
+#define am_absp_LEN		3
+#define am_absx_LEN		3
+#define am_absy_LEN		3
+#define am_abxw_LEN		3
+#define am_abyw_LEN		3
+#define am_dpag_LEN		2
+#define am_dpgx_LEN		2
+#define am_dpgy_LEN		2
+#define am_dpgi_LEN		2
+#define am_dpix_LEN		2
+#define am_dpiy_LEN		2
+#define am_dpyw_LEN		2
+#define am_dpil_LEN		2
+#define am_dily_LEN		2
+#define am_srel_LEN		2
+#define am_sriy_LEN		2
+#define am_immm_LEN		IMMM_LEN
+#define am_immx_LEN		IMMX_LEN
+
+#define IMMM_LEN		2
+#define IMMX_LEN		2
+
+#define CPU			CpuModeE11
+
 const OpcodeSet		CpuModeE11::opcodeSet =
 {
 	OPCODE_SET
 };
 
+#undef IMMM_LEN
+#undef IMMX_LEN
+#define IMMM_LEN		3
+#define IMMX_LEN		3
+
+#undef CPU
+#define CPU			CpuModeN00
+
 const OpcodeSet		CpuModeN00::opcodeSet =
 {
 	OPCODE_SET
 };
 
+#undef IMMX_LEN
+#define IMMX_LEN		2
+
+#undef CPU
+#define CPU			CpuModeN01
+
 const OpcodeSet		CpuModeN01::opcodeSet =
 {
 	OPCODE_SET
 };
 
+#undef IMMM_LEN
+#undef IMMX_LEN
+#define IMMM_LEN		2
+#define IMMX_LEN		3
+
+#undef CPU
+#define CPU			CpuModeN10
+
 const OpcodeSet		CpuModeN10::opcodeSet =
 {
 	OPCODE_SET
 };
 
+#undef IMMX_LEN
+#define IMMX_LEN		2
+
+#undef CPU
+#define CPU			CpuModeN11
+
 const OpcodeSet		CpuModeN11::opcodeSet =
 {
 	OPCODE_SET
@@ -0,0 +1,106 @@
+//==============================================================================
+//  _____ __  __        __  ____   ____ ___  _  __   
+// | ____|  \/  |      / /_| ___| / ___( _ )/ |/ /_  
+// |  _| | |\/| |_____| '_ \___ \| |   / _ \| | '_ \ 
+// | |___| |  | |_____| (_) |__) | |__| (_) | | (_) |
+// |_____|_|__|_|___ __\___/____/ \____\___/|_|\___/ 
+// | ____/ ___||  _ \___ /___ \                      
+// |  _| \___ \| |_) ||_ \ __) |                     
+// | |___ ___) |  __/___) / __/                      
+// |_____|____/|_|  |____/_____|                     
+//
+//------------------------------------------------------------------------------                                                   
+// Copyright (C),2019 Andrew John Jacobs
+// All rights reserved.
+//
+// This work is made available under the terms of the Creative Commons
+// Attribution-NonCommercial-ShareAlike 4.0 International license. Open the
+// following URL to see the details.
+//
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//------------------------------------------------------------------------------
+// Notes:
+//
+//==============================================================================
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+//==============================================================================
+
+// The function called when an event is due. It is passed the cycle it was
+// due at so that a periodic event can schedule its next occurrence exactly.
+typedef void (*Event) (uint64_t when);
+
+// A queue of device events ordered by the emulated cycle they are due at.
+// The events are held in a binary min-heap so the next is always first.
+template <uint16_t size> class Scheduler
+{
+private:
+    struct Entry {
+        uint64_t        when;
+        Event           pEvent;
+    };
+
+    uint64_t            cycle;
+    uint16_t            count;
+    Entry               heap [size];
+
+public:
+    // Construct an empty Scheduler instance
+    Scheduler (void)
+        : cycle(0), count(0)
+    { }
+
+    // Return the current emulated cycle
+    uint64_t now (void) const
+    {
+        return (cycle);
+    }
+
+    // Add an event due at an emulated cycle. The Scheduler MUST NOT be full.
+    void schedule (uint64_t when, Event pEvent)
+    {
+        uint16_t index = count++;
+
+        while (index && (heap [(index - 1) / 2].when > when)) {
+            heap [index] = heap [(index - 1) / 2];
+            index = (index - 1) / 2;
+        }
+        heap [index].when = when;
+        heap [index].pEvent = pEvent;
+    }
+
+    // Return the number of cycles until the next event, or the limit if it
+    // is further away than that.
+    uint32_t until (uint32_t limit) const
+    {
+        if (!count || (heap [0].when >= cycle + limit)) return (limit);
+        return ((heap [0].when > cycle) ? heap [0].when - cycle : 0);
+    }
+
+    // Move the emulated time on and call every event that is now due, in
+    // order. An event may schedule others, including itself.
+    void advance (uint32_t cycles)
+    {
+        cycle += cycles;
+
+        while (count && (heap [0].when <= cycle)) {
+            Entry       next = heap [0];
+            Entry       last = heap [--count];
+            uint16_t    index = 0;
+
+            for (uint16_t child; (child = 2 * index + 1) < count; index = child) {
+                if ((child + 1 < count) && (heap [child + 1].when < heap [child].when)) ++child;
+                if (last.when <= heap [child].when) break;
+                heap [index] = heap [child];
+            }
+            heap [index] = last;
+
+            (next.pEvent) (next.when);
+        }
+    }
+ };
+#endif
@@ -0,0 +1,189 @@
+//==============================================================================
+//  _____ __  __        __  ____   ____ ___  _  __   
+// | ____|  \/  |      / /_| ___| / ___( _ )/ |/ /_  
+// |  _| | |\/| |_____| '_ \___ \| |   / _ \| | '_ \ 
+// | |___| |  | |_____| (_) |__) | |__| (_) | | (_) |
+// |_____|_|__|_|___ __\___/____/ \____\___/|_|\___/ 
+// | ____/ ___||  _ \___ /___ \                      
+// |  _| \___ \| |_) ||_ \ __) |                     
+// | |___ ___) |  __/___) / __/                      
+// |_____|____/|_|  |____/_____|                     
+//
+//------------------------------------------------------------------------------                                                   
+// Copyright (C),2019 Andrew John Jacobs
+// All rights reserved.
+//
+// This work is made available under the terms of the Creative Commons
+// Attribution-NonCommercial-ShareAlike 4.0 International license. Open the
+// following URL to see the details.
+//
+// http://creativecommons.org/licenses/by-nc-sa/4.0/
+//------------------------------------------------------------------------------
+// Notes:
+//
+//==============================================================================
+
+#include <Arduino.h>
+
+#pragma GCC optimize ("-O3")
+
+#include "Emulator.h"
+
+#if THREADED
+
+//==============================================================================
+// Threaded Interpreter
+//------------------------------------------------------------------------------
+
+// Each opcode set has its own copy of the execution loop built with GCC's
+// labels-as-values extension. The addressing mode and operation functions
+// are inlined into a labelled body and every instruction ends by jumping
+// directly to the body for the next, rather than returning to a caller that
+// makes an indirect call through the OpcodeSet table.
+//
+// A fused pair runs the two opcode functions back to back and skips the
+// dispatch in between. If the first writes to decoded code the pair is
+// abandoned and the second instruction is fetched again from a new block.
+//
+// A loop returns true when the run is over or false if an instruction has
+// switched to a different opcode set and the run should continue with its
+// loop. Only opcodes that end a block can change the mode, stop or wait so
+// these conditions are only checked when a new block is needed.
+//
+// The position in the current block is held in locals while the loop runs
+// and only written back to the registers when it exits.
+
+#undef OPCODE
+#define OPCODE(HX,AM,OP,AD) \
+	lb_##HX: \
+		{ \
+			register uint8_t	cy = AM (eal, eah); \
+			cy += OP (eal, eah); \
+			cy = AM##_CY + OP##_CY + AD + Cycles::extra(cy); \
+			SHOW_CY(cy); \
+			cycles += cy; \
+		} \
+		goto next;
+
+#define LABEL_SET \
+	{ \
+		&&lb_00, &&lb_01, &&lb_02, &&lb_03, &&lb_04, &&lb_05, &&lb_06, &&lb_07, \
+		&&lb_08, &&lb_09, &&lb_0a, &&lb_0b, &&lb_0c, &&lb_0d, &&lb_0e, &&lb_0f, \
+		&&lb_10, &&lb_11, &&lb_12, &&lb_13, &&lb_14, &&lb_15, &&lb_16, &&lb_17, \
+		&&lb_18, &&lb_19, &&lb_1a, &&lb_1b, &&lb_1c, &&lb_1d, &&lb_1e, &&lb_1f, \
+		&&lb_20, &&lb_21, &&lb_22, &&lb_23, &&lb_24, &&lb_25, &&lb_26, &&lb_27, \
+		&&lb_28, &&lb_29, &&lb_2a, &&lb_2b, &&lb_2c, &&lb_2d, &&lb_2e, &&lb_2f, \
+		&&lb_30, &&lb_31, &&lb_32, &&lb_33, &&lb_34, &&lb_35, &&lb_36, &&lb_37, \
+		&&lb_38, &&lb_39, &&lb_3a, &&lb_3b, &&lb_3c, &&lb_3d, &&lb_3e, &&lb_3f, \
+		&&lb_40, &&lb_41, &&lb_42, &&lb_43, &&lb_44, &&lb_45, &&lb_46, &&lb_47, \
+		&&lb_48, &&lb_49, &&lb_4a, &&lb_4b, &&lb_4c, &&lb_4d, &&lb_4e, &&lb_4f, \
+		&&lb_50, &&lb_51, &&lb_52, &&lb_53, &&lb_54, &&lb_55, &&lb_56, &&lb_57, \
+		&&lb_58, &&lb_59, &&lb_5a, &&lb_5b, &&lb_5c, &&lb_5d, &&lb_5e, &&lb_5f, \
+		&&lb_60, &&lb_61, &&lb_62, &&lb_63, &&lb_64, &&lb_65, &&lb_66, &&lb_67, \
+		&&lb_68, &&lb_69, &&lb_6a, &&lb_6b, &&lb_6c, &&lb_6d, &&lb_6e, &&lb_6f, \
+		&&lb_70, &&lb_71, &&lb_72, &&lb_73, &&lb_74, &&lb_75, &&lb_76, &&lb_77, \
+		&&lb_78, &&lb_79, &&lb_7a, &&lb_7b, &&lb_7c, &&lb_7d, &&lb_7e, &&lb_7f, \
+		&&lb_80, &&lb_81, &&lb_82, &&lb_83, &&lb_84, &&lb_85, &&lb_86, &&lb_87, \
+		&&lb_88, &&lb_89, &&lb_8a, &&lb_8b, &&lb_8c, &&lb_8d, &&lb_8e, &&lb_8f, \
+		&&lb_90, &&lb_91, &&lb_92, &&lb_93, &&lb_94, &&lb_95, &&lb_96, &&lb_97, \
+		&&lb_98, &&lb_99, &&lb_9a, &&lb_9b, &&lb_9c, &&lb_9d, &&lb_9e, &&lb_9f, \
+		&&lb_a0, &&lb_a1, &&lb_a2, &&lb_a3, &&lb_a4, &&lb_a5, &&lb_a6, &&lb_a7, \
+		&&lb_a8, &&lb_a9, &&lb_aa, &&lb_ab, &&lb_ac, &&lb_ad, &&lb_ae, &&lb_af, \
+		&&lb_b0, &&lb_b1, &&lb_b2, &&lb_b3, &&lb_b4, &&lb_b5, &&lb_b6, &&lb_b7, \
+		&&lb_b8, &&lb_b9, &&lb_ba, &&lb_bb, &&lb_bc, &&lb_bd, &&lb_be, &&lb_bf, \
+		&&lb_c0, &&lb_c1, &&lb_c2, &&lb_c3, &&lb_c4, &&lb_c5, &&lb_c6, &&lb_c7, \
+		&&lb_c8, &&lb_c9, &&lb_ca, &&lb_cb, &&lb_cc, &&lb_cd, &&lb_ce, &&lb_cf, \
+		&&lb_d0, &&lb_d1, &&lb_d2, &&lb_d3, &&lb_d4, &&lb_d5, &&lb_d6, &&lb_d7, \
+		&&lb_d8, &&lb_d9, &&lb_da, &&lb_db, &&lb_dc, &&lb_dd, &&lb_de, &&lb_df, \
+		&&lb_e0, &&lb_e1, &&lb_e2, &&lb_e3, &&lb_e4, &&lb_e5, &&lb_e6, &&lb_e7, \
+		&&lb_e8, &&lb_e9, &&lb_ea, &&lb_eb, &&lb_ec, &&lb_ed, &&lb_ee, &&lb_ef, \
+		&&lb_f0, &&lb_f1, &&lb_f2, &&lb_f3, &&lb_f4, &&lb_f5, &&lb_f6, &&lb_f7, \
+		&&lb_f8, &&lb_f9, &&lb_fa, &&lb_fb, &&lb_fc, &&lb_fd, &&lb_fe, &&lb_ff, \
+		ALL_FUSIONS(FUSE_LABEL) \
+	}
+
+#define FUSE_LABEL(A,B)	&&lb_##A##_##B,
+
+#define FUSE(A,B) \
+	lb_##A##_##B: \
+		{ \
+			register uint8_t	cy = op_##A (); \
+			SHOW_CY(cy); \
+			cycles += cy; \
+		} \
+		if (gen != Memory::generation) goto next; \
+		SHOW_PC(); \
+		--left; \
+		++pCode; \
+		++pc.w; \
+		++pFetch; \
+		++count; \
+		{ \
+			register uint8_t	cy = op_##B (); \
+			SHOW_CY(cy); \
+			cycles += cy; \
+		} \
+		goto next;
+
+#define EXECUTE(CLASS) \
+	bool CLASS::execute(Slice &slice, uint32_t budget) \
+	{ \
+		static const void * const labels[FUSED_BASE + FUSIONS] = LABEL_SET; \
+		\
+		register uint32_t		cycles = slice.cycles; \
+		register uint32_t		count = slice.instructions; \
+		register uint32_t		left = remaining; \
+		register uint32_t		gen = generation; \
+		register const uint16_t	*pCode = left ? pBlock->code + (pBlock->count - left) : NULL; \
+		register uint32_t		eal, eah; \
+		register bool			done = true; \
+		\
+	next: \
+		if ((left == 0) || (gen != Memory::generation)) { \
+			cycles += owed; \
+			owed = 0; \
+			spent.store(cycles, std::memory_order_relaxed); \
+			if (pOpcodeSet != &opcodeSet) { \
+				done = false; \
+				goto exit; \
+			} \
+			if (count && isDone(cycles, budget)) goto exit; \
+			\
+			pBlock = cache.lookup(pbr.a | pc.w, pOpcodeSet); \
+			if (pBlock->idle) { \
+				slice.cycles = cycles; \
+				slice.instructions = count; \
+				if (isIdle(pBlock, slice, budget)) return (true); \
+			} \
+			\
+			pCode = pBlock->code; \
+			pFetch = pBlock->bytes; \
+			left = pBlock->count; \
+			gen = Memory::generation; \
+		} \
+		\
+		SHOW_PC(); \
+		--left; \
+		++pc.w; \
+		++pFetch; \
+		++count; \
+		goto *labels[*pCode++]; \
+		\
+		ALL_OPCODES \
+		ALL_FUSIONS(FUSE) \
+		\
+	exit: \
+		remaining = left; \
+		generation = gen; \
+		slice.cycles = cycles; \
+		slice.instructions = count; \
+		return (done); \
+	}
+
+EXECUTE(CpuModeE11)
+EXECUTE(CpuModeN00)
+EXECUTE(CpuModeN01)
+EXECUTE(CpuModeN10)
+EXECUTE(CpuModeN11)
+
+#endif
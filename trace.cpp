@@ -46,25 +46,25 @@ const char *Trace::toHex(uint32_t value, uint16_t digits)
 	return (pBuffer);
 }
 
-void Trace::start(void)
+void Trace::start(const Registers &r)
 {
 	if (enabled) {
-		cout << toHex(pbr.b, 2) << ':';
-		cout << toHex(pc.w, 4) << ' ';
-		cout << toHex(Memory::getByte(pbr.a | pc.w), 2) << ' ';
+		cout << toHex(r.pbr.b, 2) << ':';
+		cout << toHex(r.pc.w, 4) << ' ';
+		cout << toHex(Memory::getByte(r.pbr.a | r.pc.w), 2) << ' ';
 	}
 }
 
-void Trace::bytes(uint16_t count)
+void Trace::bytes(const Registers &r, uint16_t count)
 {
 	if (enabled) {
-		cout << ((count >= 1) ? toHex(Memory::getByte(pbr.a | (pc.w + 0)), 2) : "  ") << ' ';
-		cout << ((count >= 2) ? toHex(Memory::getByte(pbr.a | (pc.w + 1)), 2) : "  ") << ' ';
-		cout << ((count >= 3) ? toHex(Memory::getByte(pbr.a | (pc.w + 2)), 2) : "  ") << ' ';
+		cout << ((count >= 1) ? toHex(Memory::getByte(r.pbr.a | (r.pc.w + 0)), 2) : "  ") << ' ';
+		cout << ((count >= 2) ? toHex(Memory::getByte(r.pbr.a | (r.pc.w + 1)), 2) : "  ") << ' ';
+		cout << ((count >= 3) ? toHex(Memory::getByte(r.pbr.a | (r.pc.w + 2)), 2) : "  ") << ' ';
 	}
 }
 
-void Trace::trace(const char *pOpcode, uint32_t eal, uint32_t eah)
+void Trace::trace(const Registers &r, const char *pOpcode, uint32_t eal, uint32_t eah)
 {
 	if (enabled) {
 		cout << pOpcode << " {";
@@ -73,52 +73,52 @@ void Trace::trace(const char *pOpcode, uint32_t eal, uint32_t eah)
 		cout << toHex(eah >> 16, 2) << ':';
 		cout << toHex(eah, 4) << "} ";
 
-		cout << "E=" << (e ? '1' : '0') << ' ';
+		cout << "E=" << (r.e ? '1' : '0') << ' ';
 
 		cout << "P="
-			<< (p.n ? 'N' : '.')
-			<< (p.v ? 'V' : '.')
-			<< (p.m ? 'M' : '.')
-			<< (p.x ? 'X' : '.')
-			<< (p.d ? 'D' : '.')
-			<< (p.i ? 'I' : '.')
-			<< (p.z ? 'Z' : '.')
-			<< (p.c ? 'C' : '.') << ' ';
+			<< (r.getn() ? 'N' : '.')
+			<< (r.p.v ? 'V' : '.')
+			<< (r.p.m ? 'M' : '.')
+			<< (r.p.x ? 'X' : '.')
+			<< (r.p.d ? 'D' : '.')
+			<< (r.p.i ? 'I' : '.')
+			<< (r.getz() ? 'Z' : '.')
+			<< (r.p.c ? 'C' : '.') << ' ';
 
 		cout << "C=";
-		if (e || p.m) {
-			cout << toHex(c.h, 2) << '[';
-			cout << toHex(c.l, 2) << "] ";
+		if (r.e || r.p.m) {
+			cout << toHex(r.c.h, 2) << '[';
+			cout << toHex(r.c.l, 2) << "] ";
 		}
 		else
-			cout << '[' << toHex(c.w, 4) << "] ";
+			cout << '[' << toHex(r.c.w, 4) << "] ";
 
 		cout << "X=";
-		if (e || p.x) {
-			cout << toHex(x.h, 2) << '[';
-			cout << toHex(x.l, 2) << "] ";
+		if (r.e || r.p.x) {
+			cout << toHex(r.x.h, 2) << '[';
+			cout << toHex(r.x.l, 2) << "] ";
 		}
 		else
-			cout << '[' << toHex(x.w, 4) << "] ";
+			cout << '[' << toHex(r.x.w, 4) << "] ";
 
 		cout << "Y=";
-		if (e || p.x) {
-			cout << toHex(y.h, 2) << '[';
-			cout << toHex(y.l, 2) << "] ";
+		if (r.e || r.p.x) {
+			cout << toHex(r.y.h, 2) << '[';
+			cout << toHex(r.y.l, 2) << "] ";
 		}
 		else
-			cout << '[' << toHex(y.w, 4) << "] ";
+			cout << '[' << toHex(r.y.w, 4) << "] ";
 
-		cout << "DP=" << toHex(dp.w, 4) << ' ';
+		cout << "DP=" << toHex(r.dp.w, 4) << ' ';
 
 		cout << "SP=";
-		if (e) {
-			cout << toHex(sp.h, 2) << '[';
-			cout << toHex(sp.l, 2) << "] {";
+		if (r.e) {
+			cout << toHex(r.sp.h, 2) << '[';
+			cout << toHex(r.sp.l, 2) << "] {";
 
 			Word	xp;
 			
-			xp.w = sp.w;
+			xp.w = r.sp.w;
 
 			++xp.l; cout << toHex(Memory::getByte(xp.w), 2) << ' ';
 			++xp.l; cout << toHex(Memory::getByte(xp.w), 2) << ' ';
@@ -126,15 +126,15 @@ void Trace::trace(const char *pOpcode, uint32_t eal, uint32_t eah)
 			++xp.l; cout << toHex(Memory::getByte(xp.w), 2) << "} ";
 		}
 		else {
-			cout << '[' << toHex(sp.w, 4) << "] {";
+			cout << '[' << toHex(r.sp.w, 4) << "] {";
 
-			cout << toHex(Memory::getByte(sp.w + 1), 2) << ' ';
-			cout << toHex(Memory::getByte(sp.w + 2), 2) << ' ';
-			cout << toHex(Memory::getByte(sp.w + 3), 2) << ' ';
-			cout << toHex(Memory::getByte(sp.w + 4), 2) << "} ";
+			cout << toHex(Memory::getByte(r.sp.w + 1), 2) << ' ';
+			cout << toHex(Memory::getByte(r.sp.w + 2), 2) << ' ';
+			cout << toHex(Memory::getByte(r.sp.w + 3), 2) << ' ';
+			cout << toHex(Memory::getByte(r.sp.w + 4), 2) << "} ";
 		}
 
-		cout << "DBR=" << toHex(dbr.b, 2) << ' ';
+		cout << "DBR=" << toHex(r.dbr.b, 2) << ' ';
 	}
 }
 